@@ -0,0 +1,355 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Archetype.hpp"
+#include "ArchetypeEntity.hpp"
+#include "Components.hpp"
+#include "Prefab.hpp"
+
+namespace gquest {
+
+    BoxedComponentColumn::BoxedComponentColumn(idtype component_id) : _componentId(component_id), _components() { }
+
+    idtype BoxedComponentColumn::GetComponentId() const {
+        return _componentId;
+    }
+
+    uint_ BoxedComponentColumn::Size() const {
+        return _components.size();
+    }
+
+    ComponentPtr BoxedComponentColumn::At(uint_ row) {
+        return _components[row].get();
+    }
+
+    void BoxedComponentColumn::Push(ComponentPtr component) {
+        _components.push_back(ComponentUPtr(component));
+    }
+
+    bool BoxedComponentColumn::PushCopy(IComponent const &) {
+        return false;
+    }
+
+    void BoxedComponentColumn::Reserve(uint_ rows) {
+        _components.reserve(rows);
+    }
+
+    void BoxedComponentColumn::Replace(uint_ row, ComponentPtr component) {
+        _components[row] = ComponentUPtr(component);
+    }
+
+    void BoxedComponentColumn::MoveRowTo(uint_ row, IComponentColumn & dest) {
+        static_cast<BoxedComponentColumn&>(dest)._components.push_back(std::move(_components[row]));
+        Remove(row);
+    }
+
+    void BoxedComponentColumn::Remove(uint_ row) {
+        if(row + 1 != _components.size()) {
+            _components[row] = std::move(_components.back());
+        }
+        _components.pop_back();
+    }
+
+
+    ui64 Archetype::_nextLayoutVersion = 1;
+
+    Archetype::Archetype(ComponentSignature const & signature, vec<uptr<IComponentColumn>> columns) :
+        _signature(signature), _columns(std::move(columns)), _entities(), _layoutVersion(_nextLayoutVersion++) {
+        _slotColumns.fill(nullptr);
+        for(auto & column : _columns) {
+            auto slot = ComponentSlots::Of(column->GetComponentId());
+            if(slot < MaxComponentSlots) {
+                _slotColumns[slot] = column.get();
+                _mask.set(slot);
+            }
+        }
+    }
+
+    ComponentSignature const & Archetype::GetSignature() const {
+        return _signature;
+    }
+
+    ComponentMask const & Archetype::GetMask() const {
+        return _mask;
+    }
+
+    bool Archetype::HasComponentOfType(idtype component_id) const {
+        return std::binary_search(std::begin(_signature), std::end(_signature), component_id);
+    }
+
+    bool Archetype::HasComponentsOfTypes(ComponentSignature const & component_ids) const {
+        for(auto component_id : component_ids) {
+            if(!HasComponentOfType(component_id)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ptr<IComponentColumn> Archetype::GetColumn(idtype component_id) const {
+        auto iter = std::lower_bound(std::begin(_signature), std::end(_signature), component_id);
+        if((iter == std::end(_signature)) || (*iter != component_id)) {
+            return nullptr;
+        }
+        return _columns[iter - std::begin(_signature)].get();
+    }
+
+    uint_ Archetype::Size() const {
+        return _entities.size();
+    }
+
+    ptr<ArchetypeEntity> Archetype::GetEntity(uint_ row) const {
+        return _entities[row];
+    }
+
+    void Archetype::reserve(uint_ rows) {
+        for(auto & column : _columns) {
+            column->Reserve(rows);
+        }
+        _entities.reserve(rows);
+    }
+
+    void Archetype::pushEntity(ptr<ArchetypeEntity> entity) {
+        layoutChanged();
+        entity->_archetype = this;
+        entity->_signature = _mask;
+        entity->_row = _entities.size();
+        _entities.push_back(entity);
+    }
+
+    void Archetype::popEntity(uint_ row) {
+        layoutChanged();
+        if(row + 1 != _entities.size()) {
+            _entities[row] = _entities.back();
+            _entities[row]->_row = row;
+        }
+        _entities.pop_back();
+    }
+
+    void Archetype::layoutChanged() {
+        _layoutVersion = _nextLayoutVersion++;
+    }
+
+
+    uptr<ArchetypeStorage> ArchetypeStorage::_instance = nullptr;
+
+    ArchetypeStorage::ArchetypeStorage() : _archetypes(), _columnFactories() {
+        RegisterValueColumn<components::Name>(components::Name::TypeId);
+        RegisterValueColumn<components::Position>(components::Position::TypeId);
+        RegisterValueColumn<components::Cell>(components::Cell::TypeId);
+    }
+
+    ptr<Archetype> ArchetypeStorage::GetArchetype(ComponentSignature signature) {
+        std::sort(std::begin(signature), std::end(signature));
+        signature.erase(std::unique(std::begin(signature), std::end(signature)), std::end(signature));
+        auto iter = _archetypes.find(signature);
+        if(iter != std::end(_archetypes)) {
+            return iter->second.get();
+        }
+        vec<uptr<IComponentColumn>> columns;
+        columns.reserve(signature.size());
+        for(auto component_id : signature) {
+            columns.push_back(createColumn(component_id));
+        }
+        auto archetype = new Archetype(signature, std::move(columns));
+        _archetypes[signature] = uptr<Archetype>(archetype);
+        return archetype;
+    }
+
+    void ArchetypeStorage::AddComponents(ptr<ArchetypeEntity> entity, vec<ComponentPtr> const & components) {
+        auto source = entity->_archetype;
+        ComponentSignature signature;
+        if(source != nullptr) {
+            signature = source->GetSignature();
+        }
+        vec<ComponentPtr> added;
+        vec<ComponentPtr> replacements;
+        for(auto component : components) {
+            component->SetParent(entity);
+            auto component_id = component->GetId();
+            if((source != nullptr) && source->HasComponentOfType(component_id)) {
+                replacements.push_back(component);
+                continue;
+            }
+            auto iter = std::lower_bound(std::begin(signature), std::end(signature), component_id);
+            if((iter != std::end(signature)) && (*iter == component_id)) {
+                // Added twice in one go; the later one replaces the earlier after the move
+                replacements.push_back(component);
+                continue;
+            }
+            signature.insert(iter, component_id);
+            added.push_back(component);
+        }
+        if(!added.empty()) {
+            migrate(entity, GetArchetype(signature), added);
+        }
+        for(auto component : replacements) {
+            entity->_archetype->GetColumn(component->GetId())->Replace(entity->_row, component);
+            entity->_archetype->layoutChanged();
+        }
+    }
+
+    void ArchetypeStorage::AddComponent(ptr<ArchetypeEntity> entity, ComponentPtr component) {
+        auto source = entity->_archetype;
+        auto component_id = component->GetId();
+        if((source == nullptr) || source->HasComponentOfType(component_id)) {
+            AddComponents(entity, vec<ComponentPtr>{ component });
+            return;
+        }
+        component->SetParent(entity);
+        auto edge = source->_addEdges.find(component_id);
+        ptr<Archetype> dest;
+        if(edge != std::end(source->_addEdges)) {
+            dest = edge->second;
+        } else {
+            auto signature = source->GetSignature();
+            signature.push_back(component_id);
+            dest = GetArchetype(signature);
+            source->_addEdges[component_id] = dest;
+        }
+        migrate(entity, dest, vec<ComponentPtr>{ component });
+    }
+
+    void ArchetypeStorage::RemoveComponent(ptr<ArchetypeEntity> entity, idtype component_id) {
+        auto source = entity->_archetype;
+        if((source == nullptr) || !source->HasComponentOfType(component_id)) {
+            return;
+        }
+        auto edge = source->_removeEdges.find(component_id);
+        ptr<Archetype> dest;
+        if(edge != std::end(source->_removeEdges)) {
+            dest = edge->second;
+        } else {
+            auto signature = source->GetSignature();
+            signature.erase(std::find(std::begin(signature), std::end(signature), component_id));
+            dest = GetArchetype(signature);
+            source->_removeEdges[component_id] = dest;
+        }
+        migrate(entity, dest, { });
+    }
+
+    void ArchetypeStorage::RemoveAllComponents(ptr<ArchetypeEntity> entity) {
+        migrate(entity, nullptr, { });
+    }
+
+    void ArchetypeStorage::Instantiate(Prefab const & prefab, ptr<ArchetypeEntity> entity, ptr<IComponent const> override_component) {
+        instantiate(prefab, archetypeOf(prefab), entity, override_component);
+    }
+
+    void ArchetypeStorage::Instantiate(Prefab const & prefab, vec<ptr<ArchetypeEntity>> const & entities, vec<ptr<IComponent const>> const & overrides) {
+        auto archetype = archetypeOf(prefab);
+        archetype->reserve(archetype->Size() + entities.size());
+        for(uint_ i = 0; i < entities.size(); ++i) {
+            instantiate(prefab, archetype, entities[i], overrides.empty() ? nullptr : overrides[i]);
+        }
+    }
+
+    void ArchetypeStorage::ForEachArchetypeWith(ComponentSignature const & component_ids, ArchetypeCallback const & callback) {
+        for(auto & archetype : _archetypes) {
+            if((archetype.second->Size() > 0) && archetype.second->HasComponentsOfTypes(component_ids)) {
+                callback(*archetype.second);
+            }
+        }
+    }
+
+    void ArchetypeStorage::ForEachArchetypeWith(ComponentMask const & required, ArchetypeCallback const & callback) {
+        for(auto & archetype : _archetypes) {
+            if((archetype.second->Size() > 0) && ((archetype.second->GetMask() & required) == required)) {
+                callback(*archetype.second);
+            }
+        }
+    }
+
+    uint_ ArchetypeStorage::ArchetypeCount() const {
+        return _archetypes.size();
+    }
+
+    ptr<ArchetypeStorage> ArchetypeStorage::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<ArchetypeStorage>(new ArchetypeStorage());
+        }
+        return _instance.get();
+    }
+
+    uptr<IComponentColumn> ArchetypeStorage::createColumn(idtype component_id) const {
+        auto factory = _columnFactories.find(component_id);
+        if(factory != std::end(_columnFactories)) {
+            return factory->second(component_id);
+        }
+        return uptr<IComponentColumn>(new BoxedComponentColumn(component_id));
+    }
+
+    ptr<Archetype> ArchetypeStorage::archetypeOf(Prefab const & prefab) {
+        if(prefab._archetype == nullptr) {
+            prefab._archetype = GetArchetype(prefab.GetSignature());
+        }
+        return prefab._archetype;
+    }
+
+    void ArchetypeStorage::instantiate(Prefab const & prefab, ptr<Archetype> archetype, ptr<ArchetypeEntity> entity, ptr<IComponent const> override_component) {
+        if(entity->_archetype != nullptr) {
+            migrate(entity, nullptr, { });
+        }
+        // Entries and columns are both sorted by component id, so they line up
+        auto const& entries = prefab.GetEntries();
+        for(uint_ i = 0; i < entries.size(); ++i) {
+            auto & column = *archetype->_columns[i];
+            auto const& entry = entries[i];
+            ptr<IComponent const> source = entry.Template.get();
+            if((override_component != nullptr) && (override_component->GetId() == entry.ComponentId)) {
+                source = override_component;
+            }
+            if((source == nullptr) || !column.PushCopy(*source)) {
+                column.Push(entry.Make(source));
+            }
+            column.At(column.Size() - 1)->SetParent(entity);
+        }
+        archetype->pushEntity(entity);
+    }
+
+    void ArchetypeStorage::migrate(ptr<ArchetypeEntity> entity, ptr<Archetype> dest, vec<ComponentPtr> const & added) {
+        auto source = entity->_archetype;
+        auto row = entity->_row;
+        if(source != nullptr) {
+            // Every column swaps its last row into the same hole, so they stay in lockstep
+            for(auto & column : source->_columns) {
+                auto target = (dest != nullptr) ? dest->GetColumn(column->GetComponentId()) : nullptr;
+                if(target != nullptr) {
+                    column->MoveRowTo(row, *target);
+                } else {
+                    column->Remove(row);
+                }
+            }
+            source->popEntity(row);
+            entity->_archetype = nullptr;
+            entity->_row = 0;
+            entity->_signature.reset();
+        }
+        if(dest != nullptr) {
+            for(auto component : added) {
+                dest->GetColumn(component->GetId())->Push(component);
+            }
+            dest->pushEntity(entity);
+        }
+    }
+
+}
@@ -0,0 +1,401 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "IComponent.hpp"
+
+namespace gquest {
+
+    class ArchetypeEntity;
+    class Prefab;
+
+    /// <summary>
+    /// A sorted list of component ids that identifies an archetype
+    /// </summary>
+    using ComponentSignature = vec<idtype>;
+
+    /// <summary>
+    /// One densely packed column of components of a single type inside of an Archetype
+    /// </summary>
+    /// <remarks>
+    /// Rows are removed by moving the last row into the hole, so every
+    /// column of an archetype has to be changed in lockstep.
+    /// </remarks>
+    class IComponentColumn {
+    public:
+        virtual ~IComponentColumn() { }
+
+        virtual idtype GetComponentId() const = 0;
+        virtual uint_ Size() const = 0;
+        virtual ComponentPtr At(uint_ row) = 0;
+
+        /// <summary>
+        /// Appends a heap allocated component and takes ownership of it
+        /// </summary>
+        virtual void Push(ComponentPtr component) = 0;
+
+        /// <summary>
+        /// Appends a copy of a component iff the column stores its components by value
+        /// </summary>
+        /// <returns>False iff the column is boxed and nothing was appended</returns>
+        virtual bool PushCopy(IComponent const& component) = 0;
+
+        virtual void Reserve(uint_ rows) = 0;
+
+        /// <summary>
+        /// Replaces the component in a row with a heap allocated component and takes ownership of it
+        /// </summary>
+        virtual void Replace(uint_ row, ComponentPtr component) = 0;
+
+        /// <summary>
+        /// Appends a row to a column of the same type and removes it from this one
+        /// </summary>
+        virtual void MoveRowTo(uint_ row, IComponentColumn & dest) = 0;
+
+        /// <summary>
+        /// Destroys the component in a row
+        /// </summary>
+        virtual void Remove(uint_ row) = 0;
+    };
+
+    /// <summary>
+    /// A column that stores its components by value
+    /// </summary>
+    /// <remarks>
+    /// Only used for component types that are safe to relocate, since any
+    /// change to the archetype may move them. Components pushed into it
+    /// must be exactly ComponentType and not something derived from it.
+    /// </remarks>
+    template <class ComponentType>
+    class ComponentColumn : public IComponentColumn {
+    private:
+        idtype _componentId;
+        vec<ComponentType> _values;
+
+    public:
+        ComponentColumn(idtype component_id) : _componentId(component_id), _values() { }
+
+        inline vec<ComponentType> & Values() { return _values; }
+        inline vec<ComponentType> const& Values() const { return _values; }
+
+        // Inherited via IComponentColumn
+        virtual idtype GetComponentId() const override { return _componentId; }
+        virtual uint_ Size() const override { return _values.size(); }
+        virtual ComponentPtr At(uint_ row) override { return &_values[row]; }
+
+        virtual void Push(ComponentPtr component) override {
+            auto typed = static_cast<ComponentType*>(component);
+            _values.push_back(std::move(*typed));
+            delete typed;
+        }
+
+        virtual bool PushCopy(IComponent const& component) override {
+            _values.push_back(static_cast<ComponentType const&>(component));
+            return true;
+        }
+
+        virtual void Reserve(uint_ rows) override {
+            _values.reserve(rows);
+        }
+
+        virtual void Replace(uint_ row, ComponentPtr component) override {
+            auto typed = static_cast<ComponentType*>(component);
+            _values[row] = std::move(*typed);
+            delete typed;
+        }
+
+        virtual void MoveRowTo(uint_ row, IComponentColumn & dest) override {
+            static_cast<ComponentColumn&>(dest)._values.push_back(std::move(_values[row]));
+            Remove(row);
+        }
+
+        virtual void Remove(uint_ row) override {
+            if(row + 1 != _values.size()) {
+                _values[row] = std::move(_values.back());
+            }
+            _values.pop_back();
+        }
+    };
+
+    /// <summary>
+    /// A column that stores pointers to individually allocated components
+    /// </summary>
+    /// <remarks>
+    /// Used for components that hand out pointers to themselves, like the
+    /// controllers that register event handlers, so they never move.
+    /// </remarks>
+    class BoxedComponentColumn : public IComponentColumn {
+    private:
+        idtype _componentId;
+        vec<ComponentUPtr> _components;
+
+    public:
+        BoxedComponentColumn(idtype component_id);
+
+        // Inherited via IComponentColumn
+        virtual idtype GetComponentId() const override;
+        virtual uint_ Size() const override;
+        virtual ComponentPtr At(uint_ row) override;
+        virtual void Push(ComponentPtr component) override;
+        virtual bool PushCopy(IComponent const& component) override;
+        virtual void Reserve(uint_ rows) override;
+        virtual void Replace(uint_ row, ComponentPtr component) override;
+        virtual void MoveRowTo(uint_ row, IComponentColumn & dest) override;
+        virtual void Remove(uint_ row) override;
+    };
+
+    /// <summary>
+    /// Holds every entity that has exactly the same set of components, one column per component
+    /// </summary>
+    /// <remarks>
+    /// Row n of every column belongs to GetEntity(n). Pointers to components
+    /// in value columns are only good until an entity joins or leaves the
+    /// archetype, so hold on to entities rather than their components.
+    /// </remarks>
+    class Archetype {
+    private:
+        friend class ArchetypeStorage;
+
+        ComponentSignature _signature;
+        vec<uptr<IComponentColumn>> _columns;
+        std::array<ptr<IComponentColumn>, MaxComponentSlots> _slotColumns;
+        ComponentMask _mask;
+        vec<ptr<ArchetypeEntity>> _entities;
+
+        /// <summary>
+        /// Changes whenever any component of the archetype may have moved
+        /// </summary>
+        /// <remarks>
+        /// Versions come from one counter shared by every archetype, so an
+        /// entity that changes archetype never sees the version it cached.
+        /// </remarks>
+        ui64 _layoutVersion;
+        static ui64 _nextLayoutVersion;
+
+        /// <summary>
+        /// Caches the archetype reached by adding or removing a single component
+        /// </summary>
+        hashmap<idtype, ptr<Archetype>> _addEdges;
+        hashmap<idtype, ptr<Archetype>> _removeEdges;
+
+    public:
+        Archetype(ComponentSignature const& signature, vec<uptr<IComponentColumn>> columns);
+        Archetype(Archetype const&) = delete;
+        Archetype & operator =(Archetype const&) = delete;
+
+        ComponentSignature const& GetSignature() const;
+
+        /// <summary>
+        /// Returns the slots of the archetype's components
+        /// </summary>
+        /// <remarks>
+        /// Components without a slot are missing from the mask, so use
+        /// HasComponentsOfTypes to check for those.
+        /// </remarks>
+        ComponentMask const& GetMask() const;
+        bool HasComponentOfType(idtype component_id) const;
+
+        /// <summary>
+        /// Returns true iff the archetype has every component in a signature
+        /// </summary>
+        bool HasComponentsOfTypes(ComponentSignature const& component_ids) const;
+
+        /// <summary>
+        /// Returns the column for a component, or nullptr iff the archetype does not have it
+        /// </summary>
+        ptr<IComponentColumn> GetColumn(idtype component_id) const;
+
+        /// <summary>
+        /// Returns the column for a component slot, or nullptr iff the archetype does not have it
+        /// </summary>
+        inline ptr<IComponentColumn> GetColumnInSlot(uint_ slot) const { return _slotColumns[slot]; }
+
+        inline ui64 GetLayoutVersion() const { return _layoutVersion; }
+
+        /// <summary>
+        /// Returns the dense array of a component stored by value, or nullptr iff it is not stored that way
+        /// </summary>
+        template <class ComponentType>
+        vec<ComponentType> * GetValues(idtype component_id) const;
+
+        uint_ Size() const;
+        ptr<ArchetypeEntity> GetEntity(uint_ row) const;
+
+    private:
+        void reserve(uint_ rows);
+        void pushEntity(ptr<ArchetypeEntity> entity);
+        void popEntity(uint_ row);
+        void layoutChanged();
+    };
+
+    template <class ComponentType>
+    inline vec<ComponentType> * Archetype::GetValues(idtype component_id) const {
+        auto column = dynamic_cast<ComponentColumn<ComponentType>*>(GetColumn(component_id));
+        if(column == nullptr) {
+            return nullptr;
+        }
+        return &column->Values();
+    }
+
+    /// <summary>
+    /// Typed access to one component column of an Archetype, whether it is stored by value or boxed
+    /// </summary>
+    template <class ComponentType>
+    class ColumnView {
+    private:
+        vec<ComponentType> * _values;
+        ptr<IComponentColumn> _column;
+
+    public:
+        ColumnView(Archetype const& archetype) :
+            _values(archetype.GetValues<ComponentType>(ComponentType::TypeId)),
+            _column(archetype.GetColumn(ComponentType::TypeId)) { }
+
+        inline ComponentType & operator [](uint_ row) const {
+            if(_values != nullptr) {
+                return (*_values)[row];
+            }
+            return *static_cast<ComponentType*>(_column->At(row));
+        }
+    };
+
+    /// <summary>
+    /// Owns every Archetype and moves ArchetypeEntities between them as their components change
+    /// </summary>
+    /// <remarks>
+    /// Component types are stored in BoxedComponentColumns unless they have
+    /// been registered with RegisterValueColumn. None of this is thread-safe.
+    /// </remarks>
+    class ArchetypeStorage {
+    public:
+        using ColumnFactory = function<uptr<IComponentColumn>(idtype)>;
+        using ArchetypeCallback = function<void(Archetype &)>;
+
+    private:
+        map<ComponentSignature, uptr<Archetype>> _archetypes;
+        hashmap<idtype, ColumnFactory> _columnFactories;
+
+        static uptr<ArchetypeStorage> _instance;
+
+    public:
+        ArchetypeStorage();
+        ArchetypeStorage(ArchetypeStorage const&) = delete;
+        ArchetypeStorage & operator =(ArchetypeStorage const&) = delete;
+
+        /// <summary>
+        /// Stores a component type by value in archetypes created from now on
+        /// </summary>
+        template <class ComponentType>
+        void RegisterValueColumn(idtype component_id);
+
+        /// <summary>
+        /// Returns the archetype for a set of components, creating it iff it does not exist
+        /// </summary>
+        ptr<Archetype> GetArchetype(ComponentSignature signature);
+
+        /// <summary>
+        /// Adds heap allocated components to an entity, taking ownership of them
+        /// </summary>
+        /// <remarks>
+        /// The entity is moved to its new archetype once no matter how many
+        /// components are added. Components replace any of the same type.
+        /// </remarks>
+        void AddComponents(ptr<ArchetypeEntity> entity, vec<ComponentPtr> const& components);
+        void AddComponent(ptr<ArchetypeEntity> entity, ComponentPtr component);
+        void RemoveComponent(ptr<ArchetypeEntity> entity, idtype component_id);
+
+        /// <summary>
+        /// Destroys all of an entity's components and takes it out of its archetype
+        /// </summary>
+        void RemoveAllComponents(ptr<ArchetypeEntity> entity);
+
+        /// <summary>
+        /// Gives an entity a copy of every component in a prefab, replacing any components it already had
+        /// </summary>
+        /// <remarks>
+        /// An override, if given, is copied in place of the prefab's
+        /// component of the same type and must be exactly that type.
+        /// </remarks>
+        void Instantiate(Prefab const& prefab, ptr<ArchetypeEntity> entity, ptr<IComponent const> override_component = nullptr);
+
+        /// <summary>
+        /// Instantiates a prefab for a batch of entities, growing its archetype's columns once for all of them
+        /// </summary>
+        /// <remarks>
+        /// Overrides are either empty or hold one component (or nullptr) per
+        /// entity.
+        /// </remarks>
+        void Instantiate(Prefab const& prefab, vec<ptr<ArchetypeEntity>> const& entities, vec<ptr<IComponent const>> const& overrides);
+
+        /// <summary>
+        /// Calls a callback for every non-empty archetype that has all of the specified components
+        /// </summary>
+        void ForEachArchetypeWith(ComponentSignature const& component_ids, ArchetypeCallback const& callback);
+        void ForEachArchetypeWith(ComponentMask const& required, ArchetypeCallback const& callback);
+
+        /// <summary>
+        /// Walks the columns of every archetype that has all of the listed components, passing them in by reference
+        /// </summary>
+        /// <remarks>
+        /// The callback is called as callback(ArchetypeEntity&amp;, ComponentTypes&amp;...)
+        /// for every row, in column order. It must not add or remove
+        /// components nor create or destroy entities, since that can move
+        /// the columns out from under it.
+        /// </remarks>
+        template <class ...ComponentTypes, class Callback>
+        void ForEach(Callback const& callback);
+
+        uint_ ArchetypeCount() const;
+
+        static ptr<ArchetypeStorage> Get();
+
+    private:
+        uptr<IComponentColumn> createColumn(idtype component_id) const;
+        void migrate(ptr<ArchetypeEntity> entity, ptr<Archetype> dest, vec<ComponentPtr> const& added);
+        ptr<Archetype> archetypeOf(Prefab const& prefab);
+        void instantiate(Prefab const& prefab, ptr<Archetype> archetype, ptr<ArchetypeEntity> entity, ptr<IComponent const> override_component);
+    };
+
+    template <class ComponentType>
+    inline void ArchetypeStorage::RegisterValueColumn(idtype component_id) {
+        _columnFactories[component_id] = [](idtype id) {
+            return uptr<IComponentColumn>(new ComponentColumn<ComponentType>(id));
+        };
+    }
+
+    template <class ...ComponentTypes, class Callback>
+    inline void ArchetypeStorage::ForEach(Callback const& callback) {
+        static ComponentMask const required = MaskOf<ComponentTypes...>();
+        for(auto & entry : _archetypes) {
+            auto & archetype = *entry.second;
+            if((archetype.Size() == 0) || ((archetype.GetMask() & required) != required)) {
+                continue;
+            }
+            auto columns = std::make_tuple(ColumnView<ComponentTypes>(archetype)...);
+            for(uint_ row = 0; row < archetype.Size(); ++row) {
+                callback(*archetype.GetEntity(row), std::get<ColumnView<ComponentTypes>>(columns)[row]...);
+            }
+        }
+    }
+
+}
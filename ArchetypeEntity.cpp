@@ -0,0 +1,107 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "ArchetypeEntity.hpp"
+
+namespace gquest {
+
+    ArchetypeEntity::ArchetypeEntity() : _archetype(nullptr), _row(0), _cacheVersion(0), _handle() {
+        for(auto & cached : _slotCache) {
+            cached.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ArchetypeEntity::~ArchetypeEntity() {
+        RemoveAllComponents();
+    }
+
+    ptr<Archetype> ArchetypeEntity::GetArchetype() const {
+        return _archetype;
+    }
+
+    uint_ ArchetypeEntity::GetRow() const {
+        return _row;
+    }
+
+    bool ArchetypeEntity::HasComponentOfType(idtype component_id) const {
+        return (_archetype != nullptr) && _archetype->HasComponentOfType(component_id);
+    }
+
+    ComponentPtr ArchetypeEntity::GetComponent(idtype component_id) {
+        if(_archetype == nullptr) {
+            return nullptr;
+        }
+        auto column = _archetype->GetColumn(component_id);
+        if(column == nullptr) {
+            return nullptr;
+        }
+        return column->At(_row);
+    }
+
+    void ArchetypeEntity::AddComponent(ComponentPtr component) {
+        ArchetypeStorage::Get()->AddComponent(this, component);
+    }
+
+    void ArchetypeEntity::RemoveComponent(idtype component_id) {
+        ArchetypeStorage::Get()->RemoveComponent(this, component_id);
+    }
+
+    void ArchetypeEntity::RemoveAllComponents() {
+        if(_archetype != nullptr) {
+            ArchetypeStorage::Get()->RemoveAllComponents(this);
+        }
+    }
+
+    EntityHandle ArchetypeEntity::GetHandle() const {
+        return _handle;
+    }
+
+    void ArchetypeEntity::SetHandle(EntityHandle handle) {
+        _handle = handle;
+    }
+
+    ComponentPtr ArchetypeEntity::GetComponentInSlot(uint_ slot, idtype component_id) {
+        if(slot >= MaxComponentSlots) {
+            return GetComponent(component_id);
+        }
+        if(_archetype == nullptr) {
+            return nullptr;
+        }
+        auto version = _archetype->GetLayoutVersion();
+        if(_cacheVersion.load(std::memory_order_acquire) != version) {
+            for(auto & cached : _slotCache) {
+                cached.store(nullptr, std::memory_order_relaxed);
+            }
+            _cacheVersion.store(version, std::memory_order_release);
+        }
+        auto component = _slotCache[slot].load(std::memory_order_relaxed);
+        if(component == nullptr) {
+            auto column = _archetype->GetColumnInSlot(slot);
+            if(column != nullptr) {
+                component = column->At(_row);
+                _slotCache[slot].store(component, std::memory_order_relaxed);
+            }
+        }
+        return component;
+    }
+
+}
@@ -0,0 +1,115 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "IEntity.hpp"
+#include "Archetype.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// An entity whose components live in the columns of an Archetype rather than in the entity itself
+    /// </summary>
+    /// <remarks>
+    /// This is a drop-in replacement for BaseEntity. The entity object only
+    /// remembers which archetype and row it is in, and stays at the same
+    /// address for its whole life so it can still be handed around as an
+    /// IEntity.
+    /// </remarks>
+    class ArchetypeEntity : public IEntity {
+    private:
+        friend class Archetype;
+        friend class ArchetypeStorage;
+
+        ptr<Archetype> _archetype;
+        uint_ _row;
+
+        /// <summary>
+        /// Components looked up by slot, good for as long as the archetype's layout version matches
+        /// </summary>
+        /// <remarks>
+        /// Atomic because simulation systems running side by side may look
+        /// up different components of the same entity at the same time.
+        /// </remarks>
+        std::array<std::atomic<ComponentPtr>, MaxComponentSlots> _slotCache;
+        std::atomic<ui64> _cacheVersion;
+
+    protected:
+        EntityHandle _handle;
+
+    public:
+        ArchetypeEntity();
+        ArchetypeEntity(ArchetypeEntity const&) = delete;
+        ArchetypeEntity & operator =(ArchetypeEntity const&) = delete;
+        ~ArchetypeEntity();
+
+        template<class ...ComponentTypes>
+        ArchetypeEntity(ComponentTypes ...components);
+
+        template<class ...ComponentTypes>
+        void AddComponents(ComponentTypes ...components);
+
+        template<class ...IdTypes>
+        void RemoveComponents(IdTypes ...components);
+
+        /// <summary>
+        /// Returns the archetype the entity is in, or nullptr iff it has no components
+        /// </summary>
+        ptr<Archetype> GetArchetype() const;
+
+        /// <summary>
+        /// Returns the row of the entity's components within its archetype
+        /// </summary>
+        uint_ GetRow() const;
+
+        // Inherited via IEntity
+        virtual bool HasComponentOfType(idtype component_id) const override;
+        virtual ComponentPtr GetComponent(idtype component_id) override;
+        virtual void AddComponent(ComponentPtr component) override;
+        virtual void RemoveComponent(idtype component_id) override;
+        virtual EntityHandle GetHandle() const override;
+        virtual void SetHandle(EntityHandle handle) override;
+        virtual ComponentPtr GetComponentInSlot(uint_ slot, idtype component_id) override;
+
+    protected:
+        // Inherited via IEntity
+        virtual void RemoveAllComponents() override;
+    };
+
+    template<class ...ComponentTypes>
+    inline ArchetypeEntity::ArchetypeEntity(ComponentTypes ...components) : ArchetypeEntity() {
+        AddComponents(components...);
+    }
+
+    template<class ...ComponentTypes>
+    inline void ArchetypeEntity::AddComponents(ComponentTypes ...components) {
+        ArchetypeStorage::Get()->AddComponents(this, vec<ComponentPtr>{ components... });
+    }
+
+    template<class ...IdTypes>
+    inline void ArchetypeEntity::RemoveComponents(IdTypes ...components) {
+        for(auto component_id : vec<idtype>{ idtype(components)... }) {
+            RemoveComponent(component_id);
+        }
+    }
+
+}
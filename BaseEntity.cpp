@@ -24,7 +24,9 @@
 
 namespace gquest {
 
-    BaseEntity::BaseEntity() : _components() { }
+    BaseEntity::BaseEntity() : _components(), _handle() {
+        _slotCache.fill(nullptr);
+    }
 
     bool BaseEntity::HasComponentOfType(idtype component_id) const {
         auto iter = _components.find(component_id);
@@ -41,17 +43,48 @@ namespace gquest {
     void BaseEntity::AddComponent(ComponentPtr component) {
         component->SetParent(this);
         _components[component->GetId()] = ComponentUPtr(component);
+        auto slot = ComponentSlots::Of(component->GetId());
+        if(slot < MaxComponentSlots) {
+            _slotCache[slot] = component;
+            _signature.set(slot);
+        }
     }
 
     void BaseEntity::RemoveComponent(idtype component_id) {
         auto iter = _components.find(component_id);
         if(iter != std::end(_components)) {
             _components.erase(iter);
+            auto slot = ComponentSlots::Of(component_id);
+            if(slot < MaxComponentSlots) {
+                _slotCache[slot] = nullptr;
+                _signature.reset(slot);
+            }
         }
     }
 
     void BaseEntity::RemoveAllComponents() {
         _components.clear();
+        _slotCache.fill(nullptr);
+        _signature.reset();
+    }
+
+    EntityHandle BaseEntity::GetHandle() const {
+        return _handle;
+    }
+
+    void BaseEntity::SetHandle(EntityHandle handle) {
+        _handle = handle;
+    }
+
+    ComponentPtr BaseEntity::GetComponentInSlot(uint_ slot, idtype component_id) {
+        if(slot < MaxComponentSlots) {
+            return _slotCache[slot];
+        }
+        auto iter = _components.find(component_id);
+        if(iter == std::end(_components)) {
+            return nullptr;
+        }
+        return iter->second.get();
     }
 
 }
@@ -28,6 +28,12 @@ namespace gquest {
     class BaseEntity : public IEntity {
     protected:
         ComponentMap _components;
+        EntityHandle _handle;
+
+        /// <summary>
+        /// Holds the component in each slot, so slotted lookups never touch the map
+        /// </summary>
+        std::array<ComponentPtr, MaxComponentSlots> _slotCache;
     public:
         BaseEntity();
         
@@ -45,6 +51,9 @@ namespace gquest {
         virtual ComponentPtr GetComponent(idtype component_id) override;
         virtual void AddComponent(ComponentPtr component) override;
         virtual void RemoveComponent(idtype component_id) override;
+        virtual EntityHandle GetHandle() const override;
+        virtual void SetHandle(EntityHandle handle) override;
+        virtual ComponentPtr GetComponentInSlot(uint_ slot, idtype component_id) override;
 
     protected:
         template<class ComponentType, class ...ComponentTypes>
@@ -0,0 +1,525 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include <Psapi.h>
+#include <random>
+#include "Game.hpp"
+#include "CommandHandlers.hpp"
+#include "CommandQueue.hpp"
+#include "BaseEntity.hpp"
+#include "Pool.hpp"
+
+// Headless engine benchmarks. Every run measures one mode at one entity count
+// and prints a single line of key=value pairs, so that the peak memory
+// reported is that run's alone.
+//
+//   GalactiQuestBench.exe [--mode NAME] [--entities M] [--moves N] [--ticks K]
+//                         [--iterations I] [--seed S] [--fps F] [--wait W]
+//
+// simulation (default): spawns M splatters, scripts the player for N of K
+//     one-tick frames, then has them wait W ticks in a single frame, and
+//     reports ticks/s, commands/s, ObjectPool block allocations and slabs
+//     (for the spawn and for the whole run) and peak memory. It also
+//     reports how many frames the RenderScheduler, capped at F a second
+//     (0 for no cap), would have drawn and how many ticks it folded into
+//     them, over the whole run and during the wait.
+// locations: puts M bare entities in 16 systems of a World and times
+//     existence checks (I passes), moves between systems and removals,
+//     per operation, next to existence checks done by scanning every
+//     system's list for up to 1000 of them. Flat times across M mean the
+//     location index holds.
+// grid: puts M entities with a Position in one system of a World, spread
+//     like the simulation's, and times I * 1000 point, 16x16 rect and
+//     radius 8 queries on its SpatialGrid, next to I * 10 rect queries
+//     done by scanning every entity.
+// foreach: spawns M splatters and times I passes of World::ForEachInSystem
+//     over Position and Cell next to the same pass written by hand as a
+//     signature check and Get<T> per entity, then the same pair for the
+//     PlayerController, which only the player has.
+// queue: pushes M two-argument commands at random times onto one
+//     CommandQueue and pops them all, I times over, next to a
+//     std::priority_queue doing the same, and next to a std::priority_queue
+//     of the older Command that kept its arguments in a list<any>.
+//
+// Run it at 1000, 10000 and 100000 entities to compare.
+
+namespace {
+
+    using namespace gquest;
+
+    struct BenchOptions {
+        string Mode = L"simulation";
+        uint_ Entities = 1000;
+        uint_ Moves = 1000;
+        uint_ Ticks = 10000;
+        uint_ Iterations = 100;
+        ui32 Seed = 1;
+        uint_ FramesPerSecond = DEFAULT_MAX_FRAMES_PER_SECOND;
+        uint_ Wait = 0;
+    };
+
+    BenchOptions parseOptions(int argc, wchar_t * argv[]) {
+        BenchOptions options;
+        for(int i = 1; i + 1 < argc; i += 2) {
+            string option = argv[i];
+            if(option == L"--mode") {
+                options.Mode = argv[i + 1];
+                continue;
+            }
+            auto value = std::wcstoull(argv[i + 1], nullptr, 10);
+            if(option == L"--entities") {
+                options.Entities = value;
+            } else if(option == L"--moves") {
+                options.Moves = value;
+            } else if(option == L"--ticks") {
+                options.Ticks = value;
+            } else if(option == L"--iterations") {
+                options.Iterations = std::max<uint_>(value, 1);
+            } else if(option == L"--seed") {
+                options.Seed = static_cast<ui32>(value);
+            } else if(option == L"--fps") {
+                options.FramesPerSecond = value;
+            } else if(option == L"--wait") {
+                options.Wait = value;
+            } else {
+                throw std::runtime_error("Unknown option");
+            }
+        }
+        return options;
+    }
+
+    /// <summary>
+    /// Returns a square play area with about four cells per entity, and never smaller than the game's own
+    /// </summary>
+    IRect playAreaFor(uint_ entities) {
+        auto side = std::max<int_>(GAME_WIDTH, static_cast<int_>(std::ceil(std::sqrt(4.0 * static_cast<f64>(entities)))));
+        return IRect(1, 1, side, side);
+    }
+
+    ui64 commandsRun() {
+        auto handlers = CommandHandlerRegistry::Get();
+        ui64 calls = 0;
+        for(uint_ index = 0; index < CommandTypeCount; ++index) {
+            calls += handlers->GetStats(static_cast<CommandType>(index)).Calls;
+        }
+        return calls;
+    }
+
+    f64 secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// <summary>
+    /// The statistics of every ObjectPool added together
+    /// </summary>
+    PoolStatistics poolTotals() {
+        PoolStatistics totals{ "all", 0, 0, 0, 0, 0 };
+        for(auto const& pool : PoolRegistry::GetStatistics()) {
+            totals.Allocations += pool.Allocations;
+            totals.Deallocations += pool.Deallocations;
+            totals.Slabs += pool.Slabs;
+            totals.Live += pool.Live;
+        }
+        return totals;
+    }
+
+    f64 megabytes(ui64 bytes) {
+        return static_cast<f64>(bytes) / (1024.0 * 1024.0);
+    }
+
+    ui64 peakWorkingSet() {
+        PROCESS_MEMORY_COUNTERS counters = { };
+        counters.cb = sizeof(counters);
+        if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return 0;
+        }
+        return static_cast<ui64>(counters.PeakWorkingSetSize);
+    }
+
+    /// <summary>
+    /// Spawns the given number of splatters at random positions within the area through the batched Spawn path
+    /// </summary>
+    void spawnSplatters(Game & game, IRect const& area, uint_ count) {
+        auto & random = game.GetRandom();
+        vec<IVector2> positions;
+        positions.reserve(count);
+        for(uint_ i = 0; i < count; ++i) {
+            positions.push_back(IVector2(
+                random.uniform(area.Left, area.Left + area.Width - 1),
+                random.uniform(area.Top, area.Top + area.Height - 1)));
+        }
+        for(auto const& entity : LivelySplatterEntity::Spawn(positions)) {
+            game.AddEntity(entity);
+        }
+    }
+
+    void runSimulation(BenchOptions const& options) {
+        auto game = uptr<Game>(Game::Get());
+        auto area = playAreaFor(options.Entities);
+        game->Seed(options.Seed);
+        game->StartHeadless(area);
+        auto & frames = game->GetRenderScheduler();
+        frames.SetMaxFramesPerSecond(options.FramesPerSecond);
+
+        auto before_spawn = poolTotals();
+        auto spawn_start = std::chrono::steady_clock::now();
+        spawnSplatters(*game, area, options.Entities);
+        auto spawn_seconds = secondsSince(spawn_start);
+        auto after_spawn = poolTotals();
+
+        // Every frame is one tick: the first N walk the player around in a square, the rest wait
+        static CommandType const moves[] = { CommandType::MoveRight, CommandType::MoveDown, CommandType::MoveLeft, CommandType::MoveUp };
+        CommandHandlerRegistry::Get()->ResetStats();
+        auto start = std::chrono::steady_clock::now();
+        for(uint_ tick = 0; tick < options.Ticks; ++tick) {
+            auto type = (tick < options.Moves) ? moves[(tick / 8) % 4] : CommandType::Wait;
+            game->PlayFrame(InputFrame{ game->Now(), true, true, { Command(game->Now(), type) } });
+        }
+        auto frames_before_wait = frames.GetFramesRendered();
+        auto coalesced_before_wait = frames.GetTicksCoalesced();
+        auto ticks_before_wait = game->Now();
+        if(options.Wait > 0) {
+            game->PlayFrame(InputFrame{ game->Now(), true, true, { Command(game->Now() + options.Wait, CommandType::Wait) } });
+        }
+        auto seconds = secondsSince(start);
+        auto wait_ticks = game->Now() - ticks_before_wait;
+        auto commands = commandsRun();
+        auto pools = poolTotals();
+
+        std::wcout
+            << L"mode=simulation"
+            << L" entities=" << options.Entities
+            << L" ticks=" << options.Ticks
+            << L" moves=" << std::min(options.Moves, options.Ticks)
+            << L" wait=" << options.Wait
+            << L" spawn_s=" << spawn_seconds
+            << L" spawn_pool_allocations=" << (after_spawn.Allocations - before_spawn.Allocations)
+            << L" spawn_pool_slabs=" << (after_spawn.Slabs - before_spawn.Slabs)
+            << L" run_s=" << seconds
+            << L" ticks_per_s=" << (seconds > 0 ? static_cast<f64>(options.Ticks + wait_ticks) / seconds : 0.0)
+            << L" commands_per_s=" << (seconds > 0 ? static_cast<f64>(commands) / seconds : 0.0)
+            << L" pool_allocations=" << pools.Allocations
+            << L" pool_slabs=" << pools.Slabs
+            << L" pool_live=" << pools.Live
+            << L" fps=" << options.FramesPerSecond
+            << L" frames_rendered=" << frames.GetFramesRendered()
+            << L" ticks_coalesced=" << frames.GetTicksCoalesced()
+            << L" wait_ticks=" << wait_ticks
+            << L" wait_frames_rendered=" << (frames.GetFramesRendered() - frames_before_wait)
+            << L" wait_ticks_coalesced=" << (frames.GetTicksCoalesced() - coalesced_before_wait)
+            << L" peak_mb=" << megabytes(peakWorkingSet())
+            << std::endl;
+    }
+
+    void runLocations(BenchOptions const& options) {
+        constexpr sysid systems = 16;
+        std::mt19937_64 random(options.Seed);
+        EntityRegistry registry;
+        World world(&registry);
+        vec<EntityHandle> handles;
+        handles.reserve(options.Entities);
+        // The entities kept the way World kept them before it had a location index, to scan like it did
+        map<sysid, vec<EntityHandle>> lists;
+        for(uint_ i = 0; i < options.Entities; ++i) {
+            auto entity = EntityPtr(new BaseEntity());
+            world.AddEntityToSystem(entity, 1 + (i % systems));
+            handles.push_back(entity->GetHandle());
+            lists[1 + (i % systems)].push_back(entity->GetHandle());
+        }
+        std::shuffle(std::begin(handles), std::end(handles), random);
+
+        uint_ found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(uint_ iteration = 0; iteration < options.Iterations; ++iteration) {
+            for(auto handle : handles) {
+                found += world.DoesEntityExist(handle) ? 1 : 0;
+            }
+        }
+        auto lookup_seconds = secondsSince(start);
+
+        // Each scan is O(M), so only a sample of the handles is looked up this way
+        auto scans = std::min<uint_>(handles.size(), 1000);
+        start = std::chrono::steady_clock::now();
+        for(uint_ i = 0; i < scans; ++i) {
+            for(auto const& list : lists) {
+                if(std::find(std::begin(list.second), std::end(list.second), handles[i]) != std::end(list.second)) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+        auto scan_seconds = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for(auto handle : handles) {
+            world.MoveEntity(handle, 1 + (random() % systems));
+        }
+        auto move_seconds = secondsSince(start);
+
+        std::shuffle(std::begin(handles), std::end(handles), random);
+        start = std::chrono::steady_clock::now();
+        for(auto handle : handles) {
+            world.RemoveEntity(handle);
+        }
+        auto remove_seconds = secondsSince(start);
+
+        auto count = static_cast<f64>(std::max<uint_>(options.Entities, 1));
+        std::wcout
+            << L"mode=locations"
+            << L" entities=" << options.Entities
+            << L" iterations=" << options.Iterations
+            << L" exists_ns=" << (lookup_seconds * 1e9 / (count * static_cast<f64>(options.Iterations)))
+            << L" scan_exists_ns=" << (scan_seconds * 1e9 / static_cast<f64>(std::max<uint_>(scans, 1)))
+            << L" move_ns=" << (move_seconds * 1e9 / count)
+            << L" remove_ns=" << (remove_seconds * 1e9 / count)
+            << L" found=" << found
+            << std::endl;
+    }
+
+    void runGrid(BenchOptions const& options) {
+        constexpr sysid system_id = 1;
+        constexpr int_ rect_size = 16;
+        constexpr int_ radius = 8;
+        std::mt19937_64 random(options.Seed);
+        auto area = playAreaFor(options.Entities);
+        auto randomPoint = [&]() {
+            return IVector2(
+                area.Left + static_cast<int_>(random() % static_cast<ui64>(area.Width)),
+                area.Top + static_cast<int_>(random() % static_cast<ui64>(area.Height)));
+        };
+        EntityRegistry registry;
+        World world(&registry);
+        for(uint_ i = 0; i < options.Entities; ++i) {
+            world.AddEntityToSystem(EntityPtr(new BaseEntity(new components::Position(system_id, randomPoint(), true))), system_id);
+        }
+
+        vec<ptr<IEntity>> results;
+        uint_ hits = 0;
+        auto timeQueries = [&](uint_ count, function<void(IVector2 const&)> const& query) {
+            auto start = std::chrono::steady_clock::now();
+            for(uint_ i = 0; i < count; ++i) {
+                results.clear();
+                query(randomPoint());
+                hits += results.size();
+            }
+            return secondsSince(start) * 1e9 / static_cast<f64>(count);
+        };
+        auto queries = options.Iterations * 1000;
+        auto point_ns = timeQueries(queries, [&](IVector2 const& at) {
+            world.QueryEntitiesAt(at, results, system_id);
+        });
+        auto rect_ns = timeQueries(queries, [&](IVector2 const& at) {
+            world.QueryEntitiesInRect(IRect(at.X, at.Y, rect_size, rect_size), results, system_id);
+        });
+        auto radius_ns = timeQueries(queries, [&](IVector2 const& at) {
+            world.QueryEntitiesInRadius(at, radius, results, system_id);
+        });
+        auto scan_ns = timeQueries(options.Iterations * 10, [&](IVector2 const& at) {
+            IRect rect(at.X, at.Y, rect_size, rect_size);
+            world.ForEachInSystem<components::Position>([&](EntityPtr const& entity, components::Position & pos) {
+                if(rect.contains(pos.GetPosition())) {
+                    results.push_back(entity.get());
+                }
+            }, system_id);
+        });
+
+        std::wcout
+            << L"mode=grid"
+            << L" entities=" << options.Entities
+            << L" queries=" << queries
+            << L" point_ns=" << point_ns
+            << L" rect_ns=" << rect_ns
+            << L" radius_ns=" << radius_ns
+            << L" scan_rect_ns=" << scan_ns
+            << L" hits=" << hits
+            << std::endl;
+    }
+
+    void runForEach(BenchOptions const& options) {
+        constexpr sysid system_id = World::NoSystem;
+        auto game = uptr<Game>(Game::Get());
+        auto area = playAreaFor(options.Entities);
+        game->Seed(options.Seed);
+        game->StartHeadless(area);
+        spawnSplatters(*game, area, options.Entities);
+        auto world = game->GetWorld();
+
+        // Keeps the passes from being optimized away
+        ui64 checksum = 0;
+        auto timePasses = [&](function<void()> const& pass) {
+            auto start = std::chrono::steady_clock::now();
+            for(uint_ iteration = 0; iteration < options.Iterations; ++iteration) {
+                pass();
+            }
+            return secondsSince(start) * 1e6 / static_cast<f64>(options.Iterations);
+        };
+        auto foreach_us = timePasses([&]() {
+            world->ForEachInSystem<components::Position, components::Cell>([&](EntityPtr const&, components::Position & pos, components::Cell & cell) {
+                checksum += static_cast<ui64>(pos.GetPosition().X) + cell.GetCChar().Char.UnicodeChar;
+            }, system_id);
+        });
+        auto loop_us = timePasses([&]() {
+            static ComponentMask const required = MaskOf<components::Position, components::Cell>();
+            world->RunOnEntitiesInSystem([&](EntityPtr const& entity, sysid) {
+                if(entity->HasComponents(required)) {
+                    checksum += static_cast<ui64>(entity->Get<components::Position>()->GetPosition().X) + entity->Get<components::Cell>()->GetCChar().Char.UnicodeChar;
+                }
+            }, system_id);
+        });
+        auto rare_foreach_us = timePasses([&]() {
+            world->ForEachInSystem<components::PlayerController>([&](EntityPtr const&, components::PlayerController & controller) {
+                checksum += controller.CanAct() ? 1 : 0;
+            }, system_id);
+        });
+        auto rare_loop_us = timePasses([&]() {
+            static ComponentMask const required = MaskOf<components::PlayerController>();
+            world->RunOnEntitiesInSystem([&](EntityPtr const& entity, sysid) {
+                if(entity->HasComponents(required)) {
+                    checksum += entity->Get<components::PlayerController>()->CanAct() ? 1 : 0;
+                }
+            }, system_id);
+        });
+
+        std::wcout
+            << L"mode=foreach"
+            << L" entities=" << options.Entities
+            << L" iterations=" << options.Iterations
+            << L" foreach_pass_us=" << foreach_us
+            << L" loop_pass_us=" << loop_us
+            << L" rare_foreach_pass_us=" << rare_foreach_us
+            << L" rare_loop_pass_us=" << rare_loop_us
+            << L" checksum=" << checksum
+            << std::endl;
+    }
+
+    /// <summary>
+    /// Command as it was before its arguments were stored inline, kept to measure against
+    /// </summary>
+    struct ListCommand {
+        uint_ When;
+        CommandType Type;
+        list<any> Arguments;
+    };
+
+    void runQueue(BenchOptions const& options) {
+        std::mt19937_64 random(options.Seed);
+        vec<Command> commands;
+        vec<ListCommand> list_commands;
+        commands.reserve(options.Entities);
+        list_commands.reserve(options.Entities);
+        for(uint_ i = 0; i < options.Entities; ++i) {
+            // Two coordinates each, like a spawn
+            uint_ when = random() % 1024;
+            auto type = static_cast<CommandType>(random() % CommandTypeCount);
+            int_ x = static_cast<int_>(random() % 100);
+            int_ y = static_cast<int_>(random() % 100);
+            commands.push_back(Command(when, type, x, y));
+            list_commands.push_back(ListCommand{ when, type, { any(x), any(y) } });
+        }
+        // Summed over every pop, so the pops are not optimized away
+        ui64 checksum = 0;
+
+        CommandQueue queue;
+        auto start = std::chrono::steady_clock::now();
+        for(uint_ iteration = 0; iteration < options.Iterations; ++iteration) {
+            for(auto const& command : commands) {
+                queue.Push(command);
+            }
+            while(!queue.Empty()) {
+                checksum += queue.Pop().GetWhen();
+            }
+        }
+        auto queue_seconds = secondsSince(start);
+
+        // The same work on a plain binary heap, without handles or first in, first out order
+        auto later = [](Command const& lhs, Command const& rhs) { return lhs.GetWhen() > rhs.GetWhen(); };
+        std::priority_queue<Command, vec<Command>, decltype(later)> heap(later);
+        start = std::chrono::steady_clock::now();
+        for(uint_ iteration = 0; iteration < options.Iterations; ++iteration) {
+            for(auto const& command : commands) {
+                heap.push(command);
+            }
+            while(!heap.empty()) {
+                checksum -= heap.top().GetWhen();
+                heap.pop();
+            }
+        }
+        auto heap_seconds = secondsSince(start);
+
+        // The same again with the list<any> Command, which allocates for every argument it copies
+        auto list_later = [](ListCommand const& lhs, ListCommand const& rhs) { return lhs.When > rhs.When; };
+        std::priority_queue<ListCommand, vec<ListCommand>, decltype(list_later)> list_heap(list_later);
+        start = std::chrono::steady_clock::now();
+        for(uint_ iteration = 0; iteration < options.Iterations; ++iteration) {
+            for(auto const& command : list_commands) {
+                list_heap.push(command);
+            }
+            while(!list_heap.empty()) {
+                checksum += list_heap.top().When;
+                list_heap.pop();
+            }
+        }
+        auto list_seconds = secondsSince(start);
+
+        auto operations = static_cast<f64>(2 * options.Entities * options.Iterations);
+        std::wcout
+            << L"mode=queue"
+            << L" commands=" << options.Entities
+            << L" iterations=" << options.Iterations
+            << L" queue_s=" << queue_seconds
+            << L" queue_ops_per_s=" << (queue_seconds > 0 ? operations / queue_seconds : 0.0)
+            << L" priority_queue_s=" << heap_seconds
+            << L" priority_queue_ops_per_s=" << (heap_seconds > 0 ? operations / heap_seconds : 0.0)
+            << L" list_command_s=" << list_seconds
+            << L" list_command_ops_per_s=" << (list_seconds > 0 ? operations / list_seconds : 0.0)
+            << L" checksum=" << checksum
+            << std::endl;
+    }
+
+}
+
+int wmain(int argc, wchar_t * argv[]) {
+    using namespace gquest;
+    BenchOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch(std::runtime_error const& e) {
+        std::wcerr << e.what() << std::endl
+            << L"usage: GalactiQuestBench [--mode NAME] [--entities M] [--moves N] [--ticks K] [--iterations I] [--seed S] [--fps F] [--wait W]" << std::endl;
+        return 2;
+    }
+    using Mode = function<void(BenchOptions const&)>;
+    map<string, Mode> const modes = {
+        { L"simulation", runSimulation },
+        { L"grid", runGrid },
+        { L"foreach", runForEach },
+        { L"locations", runLocations },
+        { L"queue", runQueue },
+    };
+    auto mode = modes.find(options.Mode);
+    if(mode == modes.end()) {
+        std::wcerr << L"Unknown mode " << options.Mode << std::endl;
+        return 2;
+    }
+    mode->second(options);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "ChangeTracker.hpp"
+#include "IEntity.hpp"
+
+namespace gquest {
+
+    void EntityChangeSet::Add(EntityChangeList const& changes) {
+        for(auto const& change : changes) {
+            auto iter = _index.find(change.Entity);
+            if(iter == std::end(_index)) {
+                _index.insert(std::make_pair(change.Entity, _changes.size()));
+                _changes.push_back(change);
+            } else {
+                _changes[iter->second].Changed |= change.Changed;
+            }
+        }
+    }
+
+    EntityChangeList const& EntityChangeSet::GetChanges() const {
+        return _changes;
+    }
+
+    bool EntityChangeSet::IsEmpty() const {
+        return _changes.empty();
+    }
+
+    void EntityChangeSet::Clear() {
+        _changes.clear();
+        _index.clear();
+    }
+
+    uptr<ChangeTracker> ChangeTracker::_instance = nullptr;
+
+    ChangeTracker::ChangeTracker() : _version(0), _changes(), _index() { }
+
+    ui64 ChangeTracker::Record(ptr<IEntity> entity, uint_ slot) {
+        auto version = ++_version;
+        if(entity == nullptr) {
+            return version;
+        }
+        auto handle = entity->GetHandle();
+        if(!handle.IsValid()) {
+            return version;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _index.find(handle);
+        if(iter == std::end(_index)) {
+            iter = _index.insert(std::make_pair(handle, _changes.size())).first;
+            _changes.push_back(EntityChange{handle, ComponentMask()});
+        }
+        if(slot < MaxComponentSlots) {
+            _changes[iter->second].Changed.set(slot);
+        }
+        return version;
+    }
+
+    ui64 ChangeTracker::CurrentVersion() const {
+        return _version;
+    }
+
+    void ChangeTracker::Drain(EntityChangeList & changes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        changes.clear();
+        changes.swap(_changes);
+        _index.clear();
+    }
+
+    bool ChangeTracker::HasChanges() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return !_changes.empty();
+    }
+
+    ptr<ChangeTracker> ChangeTracker::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<ChangeTracker>(new ChangeTracker());
+        }
+        return _instance.get();
+    }
+
+}
@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "IComponent.hpp"
+#include "EntityHandle.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// One entity that changed, and which of its components did
+    /// </summary>
+    struct EntityChange {
+        EntityHandle Entity;
+        ComponentMask Changed;
+    };
+
+    using EntityChangeList = vec<EntityChange>;
+
+    /// <summary>
+    /// Gathers the changes of several drains, with each entity still listed once
+    /// </summary>
+    class EntityChangeSet {
+    private:
+        EntityChangeList _changes;
+        hashmap<EntityHandle, uint_> _index;
+
+    public:
+        /// <summary>
+        /// Adds changes to the set, OR'ing them into the entry of any entity that is already listed
+        /// </summary>
+        void Add(EntityChangeList const& changes);
+
+        EntityChangeList const& GetChanges() const;
+        bool IsEmpty() const;
+        void Clear();
+    };
+
+    /// <summary>
+    /// Collects the entities whose components have changed since the last Drain()
+    /// </summary>
+    /// <remarks>
+    /// Components report themselves through IComponent::markChanged(), which
+    /// also stamps them with the next version from a single counter, so any
+    /// consumer can tell whether a component changed since a version it saw.
+    /// Each entity appears in the list once, with the changes OR'ed into its
+    /// mask. Only registered entities are listed, and recording is
+    /// thread-safe.
+    /// </remarks>
+    class ChangeTracker {
+    private:
+        std::mutex _mutex;
+        std::atomic<ui64> _version;
+        EntityChangeList _changes;
+        hashmap<EntityHandle, uint_> _index;
+
+        static uptr<ChangeTracker> _instance;
+
+    public:
+        ChangeTracker();
+        ChangeTracker(ChangeTracker const&) = delete;
+        ChangeTracker & operator =(ChangeTracker const&) = delete;
+
+        /// <summary>
+        /// Returns a new version stamp, and records the change iff the entity is registered
+        /// </summary>
+        ui64 Record(ptr<IEntity> entity, uint_ slot);
+
+        /// <summary>
+        /// Returns the most recent version stamp handed out
+        /// </summary>
+        ui64 CurrentVersion() const;
+
+        /// <summary>
+        /// Moves the changes recorded so far into changes and starts a fresh list
+        /// </summary>
+        void Drain(EntityChangeList & changes);
+
+        bool HasChanges();
+
+        static ptr<ChangeTracker> Get();
+    };
+
+}
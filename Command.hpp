@@ -22,6 +22,8 @@
 #pragma once
 
 #include "GalactiQuestBase.hpp"
+#include "StringTable.hpp"
+#include "Vector2.hpp"
 
 namespace gquest {
 
@@ -40,64 +42,188 @@ namespace gquest {
         LivelySplatter_Move,
         DEBUG_BecomeSmiley,
         DEBUG_BecomePlayer,
+
+        /// <summary>
+        /// Not a command type; the number of the ones above. New types go before it.
+        /// </summary>
+        Count
+    };
+
+    /// <summary>
+    /// The number of CommandTypes, for tables indexed by type
+    /// </summary>
+    constexpr uint_ CommandTypeCount = static_cast<uint_>(CommandType::Count);
+
+    /// <summary>
+    /// Returns the step taken by one of the Move command types, or (0, 0) for any other type
+    /// </summary>
+    inline IVector2 MoveOffset(CommandType type) {
+        switch(type) {
+        case CommandType::MoveLeft: return IVector2(-1, 0);
+        case CommandType::MoveRight: return IVector2(1, 0);
+        case CommandType::MoveUp: return IVector2(0, -1);
+        case CommandType::MoveDown: return IVector2(0, 1);
+        case CommandType::MoveLeftUp: return IVector2(-1, -1);
+        case CommandType::MoveLeftDown: return IVector2(-1, 1);
+        case CommandType::MoveRightUp: return IVector2(1, -1);
+        case CommandType::MoveRightDown: return IVector2(1, 1);
+        default: return IVector2(0, 0);
+        }
+    }
+
+    /// <summary>
+    /// Returns the name of a CommandType, for reports
+    /// </summary>
+    inline wchar_t const* CommandTypeName(CommandType type) {
+        switch(type) {
+        case CommandType::None: return L"None";
+        case CommandType::Wait: return L"Wait";
+        case CommandType::MoveLeft: return L"MoveLeft";
+        case CommandType::MoveRight: return L"MoveRight";
+        case CommandType::MoveUp: return L"MoveUp";
+        case CommandType::MoveDown: return L"MoveDown";
+        case CommandType::MoveLeftUp: return L"MoveLeftUp";
+        case CommandType::MoveLeftDown: return L"MoveLeftDown";
+        case CommandType::MoveRightUp: return L"MoveRightUp";
+        case CommandType::MoveRightDown: return L"MoveRightDown";
+        case CommandType::LivelySplatter_Spawn: return L"LivelySplatter_Spawn";
+        case CommandType::LivelySplatter_Move: return L"LivelySplatter_Move";
+        case CommandType::DEBUG_BecomeSmiley: return L"DEBUG_BecomeSmiley";
+        case CommandType::DEBUG_BecomePlayer: return L"DEBUG_BecomePlayer";
+        default: return L"Unknown";
+        }
+    }
+
+    enum class ArgumentType : ui8 { None, UInt, Int, Float, String };
+
+    /// <summary>
+    /// One argument of a Command, stored in a single 64-bit word
+    /// </summary>
+    /// <remarks>
+    /// Strings are interned in the StringTable and only their symbol is
+    /// kept. Floating point arguments are f64; a float_ has to be narrowed
+    /// by the caller, since it would not fit and could not be read back
+    /// unchanged. The get overloads only succeed for the type the argument
+    /// was made from, like any's.
+    /// </remarks>
+    class CommandArgument {
+    public:
+        union Value {
+            uint_ UInt;
+            int_ Int;
+            f64 Float;
+            symbol String;
+        };
+
+    private:
+        ArgumentType _type;
+        Value _value;
+
+    public:
+        CommandArgument() : _type(ArgumentType::None) { _value.UInt = 0; }
+        CommandArgument(uint_ value) : _type(ArgumentType::UInt) { _value.UInt = value; }
+        CommandArgument(int_ value) : _type(ArgumentType::Int) { _value.Int = value; }
+        CommandArgument(f64 value) : _type(ArgumentType::Float) { _value.Float = value; }
+        CommandArgument(float_ value) = delete;
+        CommandArgument(string const& value) : _type(ArgumentType::String) {
+            _value.UInt = 0;
+            _value.String = StringTable::Get()->Intern(value);
+        }
+        CommandArgument(ArgumentType type, Value value) : _type(type), _value(value) { }
+
+        inline ArgumentType GetType() const { return _type; }
+        inline Value GetValue() const { return _value; }
+
+        inline bool get(uint_ & value) const {
+            if(_type == ArgumentType::UInt) { value = _value.UInt; return true; } else { return false; }
+        }
+        inline bool get(int_ & value) const {
+            if(_type == ArgumentType::Int) { value = _value.Int; return true; } else { return false; }
+        }
+        inline bool get(f64 & value) const {
+            if(_type == ArgumentType::Float) { value = _value.Float; return true; } else { return false; }
+        }
+        inline bool get(string & value) const {
+            if(_type == ArgumentType::String) { value = StringTable::Get()->Lookup(_value.String); return true; } else { return false; }
+        }
     };
 
+    /// <summary>
+    /// Something for a controller to do at a particular time
+    /// </summary>
+    /// <remarks>
+    /// The arguments live inline, with their types packed apart from their
+    /// values, so a Command is a fixed size, trivially copyable value and
+    /// moving it around a priority queue never allocates.
+    /// </remarks>
     class Command {
+    public:
+        static constexpr uint_ MaxArguments = 4;
+
     private:
         uint_ _when;
         CommandType _command;
-        list<any> _args;
+        ui8 _argumentCount;
+        array<ArgumentType, MaxArguments> _argumentTypes;
+        array<CommandArgument::Value, MaxArguments> _arguments;
+
     public:
         Command() = delete;
 
-        Command(uint_ when, CommandType command) : _when(when), _command(command), _args{ } { }
+        Command(uint_ when, CommandType command) : _when(when), _command(command), _argumentCount(0), _argumentTypes(), _arguments() { }
 
-        template <class ...AnyTypes>
-        Command(uint_ when, CommandType command, AnyTypes... args) : _when(when), _command(command) {
-            _args = {
-                args...
-            };
-            //addArgs(args...);
+        template <class ...ArgumentTypes>
+        Command(uint_ when, CommandType command, ArgumentTypes const&... args) : _when(when), _command(command), _argumentCount(0), _argumentTypes(), _arguments() {
+            static_assert(sizeof...(ArgumentTypes) <= MaxArguments, "Too many arguments for a Command");
+            for(auto const& argument : { CommandArgument(args)... }) {
+                _argumentTypes[_argumentCount] = argument.GetType();
+                _arguments[_argumentCount] = argument.GetValue();
+                ++_argumentCount;
+            }
         }
 
-        Command(Command const& command) : _when(command._when), _command(command._command), _args(command._args) { }
-        Command(Command && command) : _when(command._when), _command(command._command), _args(command._args) { }
+        Command(Command const& command) = default;
+        Command(Command && command) = default;
+        Command & operator =(Command const& command) = default;
+        Command & operator =(Command && command) = default;
 
-        inline Command & operator =(Command const& command) {
-            _when = command._when;
-            _command = command._command;
-            _args = command._args;
-            return *this;
+        /// <summary>
+        /// Builds a command from arguments put together at run time, such as ones read back from an InputLog, keeping at most MaxArguments of them
+        /// </summary>
+        static Command WithArguments(uint_ when, CommandType command, vec<CommandArgument> const& args) {
+            Command result(when, command);
+            for(auto const& argument : args) {
+                if(result._argumentCount == MaxArguments) {
+                    break;
+                }
+                result._argumentTypes[result._argumentCount] = argument.GetType();
+                result._arguments[result._argumentCount] = argument.GetValue();
+                ++result._argumentCount;
+            }
+            return result;
         }
 
-        inline Command & operator =(Command && command) {
-            _when = command._when;
-            _command = command._command;
-            _args = command._args;
-            return *this;
-        }
-
-        friend bool operator <(Command const& lhs, Command const& rhs);
-        friend bool operator >(Command const& lhs, Command const& rhs);
-        friend bool operator <=(Command const& lhs, Command const& rhs);
-        friend bool operator >=(Command const& lhs, Command const& rhs);
-
         inline uint_ GetWhen() const { return _when; }
         inline CommandType GetCommandType() const { return _command; }
-        inline list<any> const& GetArguments() const { return _args; }
-    };
+        inline uint_ GetArgumentCount() const { return _argumentCount; }
 
-    inline bool operator <(Command const& lhs, Command const& rhs) {
-        return lhs._when < rhs._when;
-    }
-    inline bool operator >(Command const& lhs, Command const& rhs) {
-        return lhs._when > rhs._when;
-    }
-    inline bool operator <=(Command const& lhs, Command const& rhs) {
-        return lhs._when <= rhs._when;
-    }
-    inline bool operator >=(Command const& lhs, Command const& rhs) {
-        return lhs._when >= rhs._when;
-    }
+        /// <summary>
+        /// Returns an argument, or one of type None iff there are not that many
+        /// </summary>
+        inline CommandArgument GetArgument(uint_ index) const {
+            if(index >= _argumentCount) {
+                return CommandArgument();
+            }
+            return CommandArgument(_argumentTypes[index], _arguments[index]);
+        }
+
+        /// <summary>
+        /// Reads an argument into value iff it exists and is of value's type
+        /// </summary>
+        template <class ValueType>
+        inline bool GetArgument(uint_ index, ValueType & value) const {
+            return GetArgument(index).get(value);
+        }
+    };
 
 }
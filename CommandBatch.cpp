@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "CommandBatch.hpp"
+#include "CommandHandlers.hpp"
+#include "Components.hpp"
+
+namespace gquest {
+
+    CommandBatchExecutor::CommandBatchExecutor() : CommandBatchExecutor(CommandHandlerRegistry::Get()) { }
+
+    CommandBatchExecutor::CommandBatchExecutor(ptr<CommandHandlerRegistry> registry) : _registry(registry), _batches(), _pending(0), _unfinished() { }
+
+    void CommandBatchExecutor::Gather(ptr<IEntity> entity, ptr<components::IController> controller, uint_ now) {
+        bool batched = false;
+        while(controller->CommandsAvailable() && (controller->GetTopCommand().GetWhen() <= now)) {
+            auto type = controller->GetTopCommand().GetCommandType();
+            if(_registry->HasBatchHandler(type)) {
+                _batches[static_cast<uint_>(type)].push_back(DueCommand{ entity, controller, controller->PopCommand() });
+                ++_pending;
+                batched = true;
+            } else if(batched) {
+                // Running it now would put it ahead of the commands just batched
+                _unfinished.push_back(Gathered{ entity, controller });
+                return;
+            } else {
+                _registry->Invoke(entity, controller, controller->PopCommand(), now);
+            }
+        }
+    }
+
+    void CommandBatchExecutor::Run(uint_ now) {
+        vec<Gathered> unfinished;
+        do {
+            for(uint_ index = 0; index < _batches.size(); ++index) {
+                auto & batch = _batches[index];
+                if(batch.empty()) {
+                    continue;
+                }
+                _registry->InvokeBatch(static_cast<CommandType>(index), batch, now);
+                _pending -= batch.size();
+                batch.clear();
+            }
+            unfinished.swap(_unfinished);
+            _unfinished.clear();
+            for(auto const& gathered : unfinished) {
+                Gather(gathered.Entity, gathered.Controller, now);
+            }
+        } while(_pending > 0);
+    }
+
+    uint_ CommandBatchExecutor::Pending() const {
+        return _pending;
+    }
+
+}
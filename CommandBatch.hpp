@@ -0,0 +1,100 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "Command.hpp"
+
+namespace gquest {
+
+    class IEntity;
+    class CommandHandlerRegistry;
+
+    namespace components {
+        class IController;
+    }
+
+    /// <summary>
+    /// A command that has come due, along with the entity and controller it was popped from
+    /// </summary>
+    struct DueCommand {
+        ptr<IEntity> Entity;
+        ptr<components::IController> Controller;
+        Command Cmd;
+    };
+
+    using CommandBatch = vec<DueCommand>;
+
+    /// <summary>
+    /// Groups the due commands of many controllers by CommandType and runs each group through the type's batch handler
+    /// </summary>
+    /// <remarks>
+    /// A batch handler gets every command of its type for the tick at
+    /// once, so whatever it needs (the play area, the random number
+    /// generator, the component slots) is looked up once per batch rather
+    /// than once per command. Batches run in CommandType order, and within
+    /// a batch the commands stay in the order their controllers were
+    /// gathered.
+    ///
+    /// Batch handlers come from the CommandHandlerRegistry. Commands of
+    /// types without one are run straight away while gathering, unless the
+    /// controller already has commands waiting in a batch: then gathering
+    /// it stops there, and Run picks it up again once the batches have run,
+    /// so every controller's commands still run first in, first out.
+    /// </remarks>
+    class CommandBatchExecutor {
+    private:
+        struct Gathered {
+            ptr<IEntity> Entity;
+            ptr<components::IController> Controller;
+        };
+
+        ptr<CommandHandlerRegistry> _registry;
+        array<CommandBatch, CommandTypeCount> _batches;
+        uint_ _pending;
+
+        /// <summary>
+        /// Controllers whose gathering stopped at a command without a batch handler
+        /// </summary>
+        vec<Gathered> _unfinished;
+
+    public:
+        CommandBatchExecutor();
+        explicit CommandBatchExecutor(ptr<CommandHandlerRegistry> registry);
+
+        /// <summary>
+        /// Takes every command of a controller that is due at or before now
+        /// </summary>
+        void Gather(ptr<IEntity> entity, ptr<components::IController> controller, uint_ now);
+
+        /// <summary>
+        /// Runs every batch gathered so far through its batch handler and empties them, then finishes gathering any controller that was stopped short
+        /// </summary>
+        void Run(uint_ now);
+
+        /// <summary>
+        /// Returns the number of commands gathered and not yet run
+        /// </summary>
+        uint_ Pending() const;
+    };
+
+}
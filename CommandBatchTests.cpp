@@ -0,0 +1,89 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Tests.hpp"
+#include "CommandBatch.hpp"
+#include "CommandHandlers.hpp"
+#include "Components.hpp"
+
+namespace gquest {
+
+    namespace tests {
+
+        namespace {
+
+            /// <summary>
+            /// A controller that isn't attached to anything, to queue commands on by hand
+            /// </summary>
+            class LooseController : public components::IController {
+            public:
+                LooseController() : IController(nullptr, false) { }
+
+                virtual idtype GetId() const override { return "LooseController"_id; }
+            };
+
+        }
+
+        void CommandBatchKeepsControllerOrder() {
+            // Wait is batched and MoveLeft is not; each command carries a number to tell them apart
+            CommandHandlerRegistry registry;
+            vec<uint_> ran;
+            auto record = [&ran](Command const& command) {
+                uint_ number = 0;
+                command.GetArgument(0, number);
+                ran.push_back(number);
+            };
+            registry.SetBatchHandler(CommandType::Wait, [&record](CommandBatch const& batch, uint_) {
+                for(auto const& due : batch) {
+                    record(due.Cmd);
+                }
+            });
+            registry.SetHandler(CommandType::MoveLeft, [&record](ptr<IEntity>, ptr<components::IController>, Command const& command, uint_) {
+                record(command);
+            });
+
+            LooseController first;
+            first.PushCommand(Command(1, CommandType::Wait, uint_(1)));
+            first.PushCommand(Command(1, CommandType::MoveLeft, uint_(2)));
+            first.PushCommand(Command(1, CommandType::Wait, uint_(3)));
+            first.PushCommand(Command(2, CommandType::Wait, uint_(6)));
+            LooseController second;
+            second.PushCommand(Command(0, CommandType::MoveLeft, uint_(4)));
+            second.PushCommand(Command(1, CommandType::Wait, uint_(5)));
+
+            CommandBatchExecutor executor(&registry);
+            executor.Gather(nullptr, &first, 1);
+            executor.Gather(nullptr, &second, 1);
+            Check(ran == vec<uint_>{ 4 }, "Gathering ran a command that was queued behind a batched one");
+            Check(executor.Pending() == 2, "Gathering did not stop at the first command without a batch handler");
+
+            // Both controllers' first Waits run as one batch, then first picks up where it stopped
+            executor.Run(1);
+            Check(ran == (vec<uint_>{ 4, 1, 5, 2, 3 }), "Commands did not run first in, first out per controller");
+            Check(executor.Pending() == 0, "Run left commands gathered");
+            Check(first.CommandsAvailable() && (first.GetTopCommand().GetWhen() == 2) && !second.CommandsAvailable(),
+                "Run took commands that were not due");
+        }
+
+    }
+
+}
@@ -0,0 +1,136 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "CommandHandlers.hpp"
+
+namespace gquest {
+
+    namespace {
+
+        /// <summary>
+        /// Adds the time since it was made to a handler's counters when it goes out of scope
+        /// </summary>
+        class HandlerTimer {
+        private:
+            std::atomic<ui64> & _nanoseconds;
+            std::chrono::steady_clock::time_point _start;
+
+        public:
+            HandlerTimer(std::atomic<ui64> & nanoseconds) : _nanoseconds(nanoseconds), _start(std::chrono::steady_clock::now()) { }
+            ~HandlerTimer() {
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+                _nanoseconds.fetch_add(static_cast<ui64>(elapsed.count()), std::memory_order_relaxed);
+            }
+        };
+
+    }
+
+    CommandHandlerRegistry::CommandHandlerRegistry() : _entries() {
+        ResetStats();
+    }
+
+    void CommandHandlerRegistry::SetHandler(CommandType type, Handler const & handler) {
+        auto e = entry(type);
+        if(e != nullptr) {
+            e->Single = handler;
+        }
+    }
+
+    void CommandHandlerRegistry::SetBatchHandler(CommandType type, BatchHandler const & handler) {
+        auto e = entry(type);
+        if(e != nullptr) {
+            e->Batch = handler;
+        }
+    }
+
+    bool CommandHandlerRegistry::HasHandler(CommandType type) const {
+        auto e = entry(type);
+        return (e != nullptr) && (static_cast<bool>(e->Single) || static_cast<bool>(e->Batch));
+    }
+
+    bool CommandHandlerRegistry::HasBatchHandler(CommandType type) const {
+        auto e = entry(type);
+        return (e != nullptr) && static_cast<bool>(e->Batch);
+    }
+
+    bool CommandHandlerRegistry::Invoke(ptr<IEntity> entity, ptr<components::IController> controller, Command const & command, uint_ now) {
+        auto e = entry(command.GetCommandType());
+        if(e == nullptr) {
+            return false;
+        }
+        if(e->Single) {
+            HandlerTimer timer(e->Nanoseconds);
+            e->Single(entity, controller, command, now);
+        } else if(e->Batch) {
+            HandlerTimer timer(e->Nanoseconds);
+            e->Batch(CommandBatch{ DueCommand{ entity, controller, command } }, now);
+        } else {
+            return false;
+        }
+        e->Calls.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void CommandHandlerRegistry::InvokeBatch(CommandType type, CommandBatch const & batch, uint_ now) {
+        auto e = entry(type);
+        if((e == nullptr) || !e->Batch) {
+            throw std::runtime_error("No batch handler is registered for the command type");
+        }
+        {
+            HandlerTimer timer(e->Nanoseconds);
+            e->Batch(batch, now);
+        }
+        e->Calls.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+
+    CommandHandlerStats CommandHandlerRegistry::GetStats(CommandType type) const {
+        auto e = entry(type);
+        if(e == nullptr) {
+            return CommandHandlerStats{ 0, 0 };
+        }
+        return CommandHandlerStats{ e->Calls.load(std::memory_order_relaxed), e->Nanoseconds.load(std::memory_order_relaxed) };
+    }
+
+    void CommandHandlerRegistry::ResetStats() {
+        for(auto & e : _entries) {
+            e.Calls.store(0, std::memory_order_relaxed);
+            e.Nanoseconds.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ptr<CommandHandlerRegistry> CommandHandlerRegistry::Get() {
+        // Handlers are looked up from simulation systems on several threads, so the instance is made thread-safely
+        static CommandHandlerRegistry instance;
+        return &instance;
+    }
+
+    auto CommandHandlerRegistry::entry(CommandType type) -> ptr<Entry> {
+        auto index = static_cast<uint_>(type);
+        return (index < _entries.size()) ? &_entries[index] : nullptr;
+    }
+
+    auto CommandHandlerRegistry::entry(CommandType type) const -> ptr<Entry const> {
+        auto index = static_cast<uint_>(type);
+        return (index < _entries.size()) ? &_entries[index] : nullptr;
+    }
+
+}
@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "Command.hpp"
+#include "CommandBatch.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// How many times a command type's handlers have run, and for how long altogether
+    /// </summary>
+    struct CommandHandlerStats {
+        ui64 Calls;
+        ui64 Nanoseconds;
+    };
+
+    /// <summary>
+    /// Holds the code that carries out each CommandType, in a flat table indexed by the type
+    /// </summary>
+    /// <remarks>
+    /// IController::ExecuteCommand pops the controller's next command and
+    /// hands it to the handler for its type, so adding a CommandType means
+    /// registering a handler rather than editing every controller. A type
+    /// may also have a batch handler, which CommandBatchExecutor runs on
+    /// all of the type's due commands at once. A type with only a batch
+    /// handler runs a lone command as a batch of one.
+    ///
+    /// The registry starts out empty. Each controller adds the handlers of
+    /// its commands with a static RegisterCommandHandlers, which the game
+    /// calls while setting up.
+    ///
+    /// Every command run is counted and timed, so GetStats() shows where
+    /// executing commands spends its time. The counters are atomic, since
+    /// handlers may run from systems on different threads.
+    /// </remarks>
+    class CommandHandlerRegistry {
+    public:
+        using Handler = function<void(ptr<IEntity> entity, ptr<components::IController> controller, Command const& command, uint_ now)>;
+        using BatchHandler = function<void(CommandBatch const& batch, uint_ now)>;
+
+    private:
+        struct Entry {
+            Handler Single;
+            BatchHandler Batch;
+            std::atomic<ui64> Calls;
+            std::atomic<ui64> Nanoseconds;
+        };
+
+        array<Entry, CommandTypeCount> _entries;
+
+    public:
+        CommandHandlerRegistry();
+        CommandHandlerRegistry(CommandHandlerRegistry const&) = delete;
+        CommandHandlerRegistry & operator =(CommandHandlerRegistry const&) = delete;
+
+        void SetHandler(CommandType type, Handler const& handler);
+        void SetBatchHandler(CommandType type, BatchHandler const& handler);
+        bool HasHandler(CommandType type) const;
+        bool HasBatchHandler(CommandType type) const;
+
+        /// <summary>
+        /// Runs a command through its type's handler, returning false iff the type has none
+        /// </summary>
+        bool Invoke(ptr<IEntity> entity, ptr<components::IController> controller, Command const& command, uint_ now);
+
+        /// <summary>
+        /// Runs commands that are all of one type through its batch handler, throwing std::runtime_error iff the type has none
+        /// </summary>
+        void InvokeBatch(CommandType type, CommandBatch const& batch, uint_ now);
+
+        CommandHandlerStats GetStats(CommandType type) const;
+        void ResetStats();
+
+        static ptr<CommandHandlerRegistry> Get();
+
+    private:
+        ptr<Entry> entry(CommandType type);
+        ptr<Entry const> entry(CommandType type) const;
+    };
+
+}
@@ -0,0 +1,254 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "CommandQueue.hpp"
+
+namespace gquest {
+
+    constexpr ui32 CommandQueue::NoIndex;
+    constexpr uint_ CommandQueue::MinCompaction;
+
+    CommandQueue::CommandQueue() : _heap(), _slots(), _freeSlots(), _epochs(), _laterThan(), _cancelledAt(), _nextSequence(1), _compactAt(MinCompaction) { }
+
+    CommandHandle CommandQueue::Push(Command const & command) {
+        if(_heap.size() >= _compactAt) {
+            compact();
+        }
+        auto slot = allocateSlot();
+        auto index = static_cast<ui32>(_heap.size());
+        _heap.push_back(Queued{ command, _nextSequence++, _epochs[static_cast<uint_>(command.GetCommandType())], slot });
+        _slots[slot].Index = index;
+        siftUp(index);
+        return CommandHandle(slot, _slots[slot].Generation);
+    }
+
+    Command const & CommandQueue::Top() const {
+        purgeFront();
+        return _heap.front().Cmd;
+    }
+
+    Command CommandQueue::Pop() {
+        purgeFront();
+        auto command = _heap.front().Cmd;
+        eraseAt(0);
+        return command;
+    }
+
+    bool CommandQueue::Empty() const {
+        // Cancelled commands can be left anywhere but the front
+        purgeFront();
+        return _heap.empty();
+    }
+
+    uint_ CommandQueue::Size() const {
+        uint_ size = 0;
+        for(auto const& queued : _heap) {
+            if(isLive(queued)) {
+                ++size;
+            }
+        }
+        return size;
+    }
+
+    void CommandQueue::Clear() {
+        for(auto const& queued : _heap) {
+            releaseSlot(queued.Slot);
+        }
+        _heap.clear();
+        _laterThan.clear();
+        _cancelledAt.clear();
+    }
+
+    bool CommandQueue::Cancel(CommandHandle handle) {
+        if((handle.GetSlot() >= _slots.size()) || (_slots[handle.GetSlot()].Generation != handle.GetGeneration())) {
+            return false;
+        }
+        auto index = _slots[handle.GetSlot()].Index;
+        if((index == NoIndex) || !isLive(_heap[index])) {
+            return false;
+        }
+        eraseAt(index);
+        return true;
+    }
+
+    void CommandQueue::CancelSoonerThan(uint_ when) {
+        // The commands due before when are exactly the ones that would be popped first
+        for(purgeFront(); !_heap.empty() && (_heap.front().Cmd.GetWhen() < when); purgeFront()) {
+            eraseAt(0);
+        }
+    }
+
+    void CommandQueue::CancelLaterThan(uint_ when) {
+        // A new cutoff catches everything an older one at or after its time did
+        while(!_laterThan.empty() && (_laterThan.back().When >= when)) {
+            _laterThan.pop_back();
+        }
+        if(_laterThan.empty() || (_laterThan.back().Sequence != _nextSequence)) {
+            _laterThan.push_back(Cutoff{ when, _nextSequence });
+        }
+        if(_laterThan.size() + _cancelledAt.size() > _heap.size()) {
+            compact();
+        }
+    }
+
+    void CommandQueue::CancelAt(uint_ when) {
+        _cancelledAt[when] = _nextSequence;
+        if(_laterThan.size() + _cancelledAt.size() > _heap.size()) {
+            compact();
+        }
+    }
+
+    void CommandQueue::CancelOfType(CommandType type) {
+        ++_epochs[static_cast<uint_>(type)];
+    }
+
+    bool CommandQueue::sooner(Queued const & lhs, Queued const & rhs) {
+        auto lhs_when = lhs.Cmd.GetWhen();
+        auto rhs_when = rhs.Cmd.GetWhen();
+        return (lhs_when < rhs_when) || ((lhs_when == rhs_when) && (lhs.Sequence < rhs.Sequence));
+    }
+
+    bool CommandQueue::isLive(Queued const & queued) const {
+        if(queued.Epoch != _epochs[static_cast<uint_>(queued.Cmd.GetCommandType())]) {
+            return false;
+        }
+        if(!_cancelledAt.empty()) {
+            auto cancelled = _cancelledAt.find(queued.Cmd.GetWhen());
+            if((cancelled != std::end(_cancelledAt)) && (queued.Sequence < cancelled->second)) {
+                return false;
+            }
+        }
+        if(!_laterThan.empty()) {
+            // Of the cutoffs made after this command was pushed, the first has the earliest time
+            auto cutoff = std::upper_bound(std::begin(_laterThan), std::end(_laterThan), queued.Sequence,
+                [](ui64 sequence, Cutoff const& cutoff) { return sequence < cutoff.Sequence; });
+            if((cutoff != std::end(_laterThan)) && (queued.Cmd.GetWhen() > cutoff->When)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void CommandQueue::place(ui32 index, Queued && queued) const {
+        _heap[index] = std::move(queued);
+        _slots[_heap[index].Slot].Index = index;
+    }
+
+    void CommandQueue::siftUp(ui32 index) const {
+        auto queued = std::move(_heap[index]);
+        while(index > 0) {
+            auto parent = (index - 1) / 2;
+            if(!sooner(queued, _heap[parent])) {
+                break;
+            }
+            place(index, std::move(_heap[parent]));
+            index = parent;
+        }
+        place(index, std::move(queued));
+    }
+
+    void CommandQueue::siftDown(ui32 index) const {
+        auto count = static_cast<ui32>(_heap.size());
+        auto queued = std::move(_heap[index]);
+        for(;;) {
+            auto child = 2 * index + 1;
+            if(child >= count) {
+                break;
+            }
+            if((child + 1 < count) && sooner(_heap[child + 1], _heap[child])) {
+                ++child;
+            }
+            if(!sooner(_heap[child], queued)) {
+                break;
+            }
+            place(index, std::move(_heap[child]));
+            index = child;
+        }
+        place(index, std::move(queued));
+    }
+
+    ui32 CommandQueue::allocateSlot() {
+        if(!_freeSlots.empty()) {
+            auto slot = _freeSlots.back();
+            _freeSlots.pop_back();
+            return slot;
+        }
+        _slots.push_back(Slot{ NoIndex, 1 });
+        return static_cast<ui32>(_slots.size() - 1);
+    }
+
+    void CommandQueue::releaseSlot(ui32 slot) const {
+        auto & entry = _slots[slot];
+        entry.Index = NoIndex;
+        // Generation 0 is what a default CommandHandle carries, so skip it when wrapping around
+        if(++entry.Generation == 0) {
+            entry.Generation = 1;
+        }
+        _freeSlots.push_back(slot);
+    }
+
+    void CommandQueue::eraseAt(ui32 index) const {
+        releaseSlot(_heap[index].Slot);
+        auto last = static_cast<ui32>(_heap.size() - 1);
+        if(index != last) {
+            place(index, std::move(_heap[last]));
+        }
+        _heap.pop_back();
+        if(index < last) {
+            if((index > 0) && sooner(_heap[index], _heap[(index - 1) / 2])) {
+                siftUp(index);
+            } else {
+                siftDown(index);
+            }
+        }
+    }
+
+    void CommandQueue::purgeFront() const {
+        while(!_heap.empty() && !isLive(_heap.front())) {
+            eraseAt(0);
+        }
+    }
+
+    void CommandQueue::compact() {
+        ui32 kept = 0;
+        for(ui32 index = 0; index < _heap.size(); ++index) {
+            auto & queued = _heap[index];
+            if(!isLive(queued)) {
+                releaseSlot(queued.Slot);
+                continue;
+            }
+            if(kept != index) {
+                place(kept, std::move(queued));
+            }
+            ++kept;
+        }
+        _heap.erase(std::begin(_heap) + kept, std::end(_heap));
+        for(auto index = static_cast<ui32>(_heap.size() / 2); index-- > 0;) {
+            siftDown(index);
+        }
+        // Nothing left in the heap was pushed before a watermark and caught by it
+        _laterThan.clear();
+        _cancelledAt.clear();
+        _compactAt = std::max<uint_>(MinCompaction, 2 * _heap.size());
+    }
+
+}
@@ -0,0 +1,190 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "Command.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// Refers to one command pushed onto a CommandQueue, for cancelling it later
+    /// </summary>
+    /// <remarks>
+    /// A handle is a slot in the queue's handle table and the slot's
+    /// generation. The generation goes up whenever the command in the slot
+    /// runs or is cancelled, so a stale handle just does nothing.
+    /// </remarks>
+    class CommandHandle {
+    private:
+        ui32 _slot;
+        ui32 _generation;
+
+    public:
+        constexpr CommandHandle() : _slot(0), _generation(0) { }
+        constexpr CommandHandle(ui32 slot, ui32 generation) : _slot(slot), _generation(generation) { }
+
+        inline constexpr ui32 GetSlot() const { return _slot; }
+        inline constexpr ui32 GetGeneration() const { return _generation; }
+        inline constexpr bool IsValid() const { return _generation != 0; }
+
+        friend constexpr bool operator ==(CommandHandle const& lhs, CommandHandle const& rhs);
+    };
+
+    inline constexpr bool operator ==(CommandHandle const& lhs, CommandHandle const& rhs) {
+        return (lhs._slot == rhs._slot) && (lhs._generation == rhs._generation);
+    }
+
+    /// <summary>
+    /// A priority queue of Commands ordered by time that can cancel commands without rebuilding itself
+    /// </summary>
+    /// <remarks>
+    /// Commands are kept in a binary min-heap in one vec, ordered by time
+    /// and then by the order they were pushed, so commands due at the same
+    /// time run first in, first out. Every command also owns a slot in a
+    /// handle table that tracks where it sits in the heap. Both vecs keep
+    /// their capacity, so once a queue has reached its usual size pushing
+    /// and popping never allocate.
+    ///
+    /// Cancelling one command by handle and cancelling every command due
+    /// before a time are O(log n) per command removed. The other ways of
+    /// cancelling have no heap order to follow, so they are lazy and O(1)
+    /// apiece: cancelling a CommandType bumps the type's epoch, cancelling
+    /// at a time records the push sequence it applies below for that time,
+    /// and cancelling after a time records the time with that watermark.
+    /// Commands they catch are thrown away once they reach the front. So
+    /// that such commands cannot pile up, the heap is compacted, and the
+    /// watermarks dropped, whenever it has doubled since it last was or
+    /// there are more watermarks than commands; both cost O(n) after at
+    /// least n pushes or cancels. Empty is exact, and Size walks the heap.
+    /// </remarks>
+    class CommandQueue {
+    private:
+        static constexpr ui32 NoIndex = 0xFFFFFFFFu;
+
+        struct Queued {
+            Command Cmd;
+            ui64 Sequence;
+            ui64 Epoch;
+            ui32 Slot;
+        };
+
+        struct Slot {
+            ui32 Index;
+            ui32 Generation;
+        };
+
+        /// <summary>
+        /// Commands pushed before Sequence and due after When are cancelled
+        /// </summary>
+        struct Cutoff {
+            uint_ When;
+            ui64 Sequence;
+        };
+
+        static constexpr uint_ MinCompaction = 64;
+
+        mutable vec<Queued> _heap;
+        mutable vec<Slot> _slots;
+        mutable vec<ui32> _freeSlots;
+        array<ui64, CommandTypeCount> _epochs;
+
+        /// <summary>
+        /// From CancelLaterThan, in increasing order of both time and sequence
+        /// </summary>
+        vec<Cutoff> _laterThan;
+
+        /// <summary>
+        /// From CancelAt, the sequence commands due at each time are cancelled below
+        /// </summary>
+        hashmap<uint_, ui64> _cancelledAt;
+        ui64 _nextSequence;
+        uint_ _compactAt;
+
+    public:
+        CommandQueue();
+
+        CommandHandle Push(Command const& command);
+
+        /// <summary>
+        /// Returns the earliest command; the queue must not be empty
+        /// </summary>
+        Command const& Top() const;
+
+        /// <summary>
+        /// Removes and returns the earliest command; the queue must not be empty
+        /// </summary>
+        Command Pop();
+
+        bool Empty() const;
+        uint_ Size() const;
+        void Clear();
+
+        /// <summary>
+        /// Cancels a command iff it is still queued, returning true iff it was
+        /// </summary>
+        bool Cancel(CommandHandle handle);
+
+        /// <summary>
+        /// Cancels every queued command due before when
+        /// </summary>
+        void CancelSoonerThan(uint_ when);
+
+        /// <summary>
+        /// Cancels every queued command due after when
+        /// </summary>
+        void CancelLaterThan(uint_ when);
+
+        /// <summary>
+        /// Cancels every queued command due exactly at when
+        /// </summary>
+        void CancelAt(uint_ when);
+
+        /// <summary>
+        /// Cancels every queued command of a type
+        /// </summary>
+        void CancelOfType(CommandType type);
+
+    private:
+        static bool sooner(Queued const& lhs, Queued const& rhs);
+
+        bool isLive(Queued const& queued) const;
+
+        void place(ui32 index, Queued && queued) const;
+        void siftUp(ui32 index) const;
+        void siftDown(ui32 index) const;
+        ui32 allocateSlot();
+        void releaseSlot(ui32 slot) const;
+
+        /// <summary>
+        /// Removes the command at a heap index and releases its slot
+        /// </summary>
+        void eraseAt(ui32 index) const;
+        void purgeFront() const;
+
+        /// <summary>
+        /// Removes every cancelled command in one pass, restores the heap order and forgets the watermarks
+        /// </summary>
+        void compact();
+    };
+
+}
@@ -0,0 +1,134 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include <random>
+#include "Tests.hpp"
+#include "CommandQueue.hpp"
+
+namespace gquest {
+
+    namespace tests {
+
+        namespace {
+
+            /// <summary>
+            /// A command as the brute-force model keeps it: in push order, with its handle
+            /// </summary>
+            struct ModelEntry {
+                CommandHandle Handle;
+                Command Cmd;
+                ui64 Sequence;
+            };
+
+            template<typename Predicate>
+            void removeFromModel(vec<ModelEntry> & model, Predicate && predicate) {
+                model.erase(std::remove_if(std::begin(model), std::end(model), predicate), std::end(model));
+            }
+
+        }
+
+        void CommandQueueMatchesModel() {
+            // Random pushes, pops and cancels, checked against a plain vector that is searched in full every time
+            std::mt19937_64 random(1);
+            for(int round = 0; round < 50; ++round) {
+                CommandQueue queue;
+                vec<ModelEntry> model;
+                ui64 sequence = 0;
+                for(int step = 0; step < 3000; ++step) {
+                    auto operation = random() % 10;
+                    auto when = static_cast<uint_>(random() % 50);
+                    if(operation < 4) {
+                        Command command(when, static_cast<CommandType>(random() % 5));
+                        model.push_back(ModelEntry{ queue.Push(command), command, sequence++ });
+                    } else if(operation == 4) {
+                        removeFromModel(model, [when](ModelEntry const& entry) { return entry.Cmd.GetWhen() < when; });
+                        queue.CancelSoonerThan(when);
+                    } else if(operation == 5) {
+                        removeFromModel(model, [when](ModelEntry const& entry) { return entry.Cmd.GetWhen() > when; });
+                        queue.CancelLaterThan(when);
+                    } else if(operation == 6) {
+                        removeFromModel(model, [when](ModelEntry const& entry) { return entry.Cmd.GetWhen() == when; });
+                        queue.CancelAt(when);
+                    } else if(operation == 7) {
+                        auto type = static_cast<CommandType>(random() % 5);
+                        removeFromModel(model, [type](ModelEntry const& entry) { return entry.Cmd.GetCommandType() == type; });
+                        queue.CancelOfType(type);
+                    } else if((operation == 8) && !model.empty()) {
+                        auto index = random() % model.size();
+                        Check(queue.Cancel(model[index].Handle), "Cancel missed a queued command");
+                        model.erase(std::begin(model) + index);
+                    } else if(!model.empty()) {
+                        auto earliest = std::min_element(std::begin(model), std::end(model), [](ModelEntry const& lhs, ModelEntry const& rhs) {
+                            return (lhs.Cmd.GetWhen() < rhs.Cmd.GetWhen())
+                                || ((lhs.Cmd.GetWhen() == rhs.Cmd.GetWhen()) && (lhs.Sequence < rhs.Sequence));
+                        });
+                        Check(queue.Top().GetWhen() == earliest->Cmd.GetWhen(), "Top is not the earliest command");
+                        auto command = queue.Pop();
+                        Check((command.GetWhen() == earliest->Cmd.GetWhen()) && (command.GetCommandType() == earliest->Cmd.GetCommandType()),
+                            "Pop is not first in, first out among the earliest commands");
+                        auto handle = earliest->Handle;
+                        model.erase(earliest);
+                        Check(!queue.Cancel(handle), "Cancel matched a command that already ran");
+                    }
+                    Check(queue.Size() == model.size(), "Size differs from the model");
+                    Check(queue.Empty() == model.empty(), "Empty differs from the model");
+                }
+            }
+        }
+
+        void CommandQueueHandles() {
+            CommandQueue queue;
+            Check(!queue.Cancel(CommandHandle()), "A default handle cancelled something");
+
+            auto first = queue.Push(Command(5, CommandType::Wait));
+            auto second = queue.Push(Command(5, CommandType::MoveLeft));
+            Check(first.IsValid() && second.IsValid() && !(first == second), "Handles are not distinct");
+            Check(queue.Cancel(first), "Cancel missed a queued command");
+            Check(!queue.Cancel(first), "Cancel succeeded twice");
+
+            // The freed slot is reused, but the old handle must not reach the new command
+            auto third = queue.Push(Command(3, CommandType::MoveUp));
+            Check(third.GetSlot() == first.GetSlot(), "The freed slot was not reused");
+            Check(!queue.Cancel(first), "A stale handle cancelled the command that took over its slot");
+            Check(queue.Pop().GetCommandType() == CommandType::MoveUp, "Pop is not ordered by time");
+
+            // A command dropped by CancelOfType can no longer be cancelled by its handle
+            queue.CancelOfType(CommandType::MoveLeft);
+            Check(!queue.Cancel(second), "Cancel matched a command cancelled by type");
+            Check(queue.Empty(), "CancelOfType left its command counted");
+
+            // Nor can ones dropped by CancelLaterThan or CancelAt, which also stay in the heap for a while
+            auto later = queue.Push(Command(9, CommandType::Wait));
+            auto at = queue.Push(Command(4, CommandType::Wait));
+            queue.CancelLaterThan(8);
+            queue.CancelAt(4);
+            Check(!queue.Cancel(later) && !queue.Cancel(at), "Cancel matched a command cancelled by time");
+            Check(queue.Empty() && (queue.Size() == 0), "Cancelling by time left its commands counted");
+
+            queue.Push(Command(1, CommandType::Wait));
+            queue.Clear();
+            Check(queue.Empty() && (queue.Size() == 0), "Clear left commands behind");
+        }
+
+    }
+
+}
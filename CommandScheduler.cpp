@@ -0,0 +1,181 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "CommandScheduler.hpp"
+
+namespace gquest {
+
+    constexpr uint_ CommandScheduler::SlotBits;
+    constexpr uint_ CommandScheduler::SlotsPerLevel;
+    constexpr uint_ CommandScheduler::Levels;
+
+    uptr<CommandScheduler> CommandScheduler::_instance = nullptr;
+
+    CommandScheduler::CommandScheduler() : _mutex(), _now(0), _wheel(), _overflow(), _ready() {
+        _counts.fill(0);
+    }
+
+    void CommandScheduler::Schedule(EntityHandle entity, uint_ when) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        place(CommandWakeup{ when, entity });
+    }
+
+    void CommandScheduler::Schedule(vec<CommandWakeup> const& wakeups) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(auto const& wakeup : wakeups) {
+            place(wakeup);
+        }
+    }
+
+    void CommandScheduler::Advance(uint_ now, vec<EntityHandle> & due) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        while(_now < now) {
+            // While the lower levels are empty nothing can come due before
+            // the next level above them turns, so jump straight there
+            auto next = _now + 1;
+            for(uint_ level = 0; (level < Levels) && (_counts[level] == 0); ++level) {
+                auto span = static_cast<uint_>(1) << (SlotBits * (level + 1));
+                next = std::min(now, (_now / span + 1) * span);
+            }
+            _now = next;
+            tick(due);
+        }
+        for(auto const& wakeup : _ready) {
+            due.push_back(wakeup.Entity);
+        }
+        _ready.clear();
+    }
+
+    uint_ CommandScheduler::NextWakeup() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_ready.empty()) {
+            return _now;
+        }
+        // Everything in a level is later than everything in the levels below
+        // it, and the slots of a level come due in order starting just after
+        // the current one, so the first non-empty slot found holds the answer
+        for(uint_ level = 0; level < Levels; ++level) {
+            if(_counts[level] == 0) {
+                continue;
+            }
+            auto current = (_now >> (SlotBits * level)) & (SlotsPerLevel - 1);
+            for(uint_ offset = 1; offset <= SlotsPerLevel; ++offset) {
+                auto const& slot = _wheel[level][(current + offset) & (SlotsPerLevel - 1)];
+                if(!slot.empty()) {
+                    auto earliest = NoWakeup;
+                    for(auto const& wakeup : slot) {
+                        earliest = std::min(earliest, wakeup.When);
+                    }
+                    return earliest;
+                }
+            }
+        }
+        auto earliest = NoWakeup;
+        for(auto const& wakeup : _overflow) {
+            earliest = std::min(earliest, wakeup.When);
+        }
+        return earliest;
+    }
+
+    uint_ CommandScheduler::Now() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _now;
+    }
+
+    uint_ CommandScheduler::Size() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint_ size = _overflow.size() + _ready.size();
+        for(auto count : _counts) {
+            size += count;
+        }
+        return size;
+    }
+
+    void CommandScheduler::Reset(uint_ now) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(auto & level : _wheel) {
+            for(auto & slot : level) {
+                slot.clear();
+            }
+        }
+        _counts.fill(0);
+        _overflow.clear();
+        _ready.clear();
+        _now = now;
+    }
+
+    ptr<CommandScheduler> CommandScheduler::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<CommandScheduler>(new CommandScheduler());
+        }
+        return _instance.get();
+    }
+
+    void CommandScheduler::place(CommandWakeup const & wakeup) {
+        if(wakeup.When <= _now) {
+            _ready.push_back(wakeup);
+            return;
+        }
+        for(uint_ level = 0; level < Levels; ++level) {
+            auto shift = SlotBits * (level + 1);
+            if((wakeup.When >> shift) == (_now >> shift)) {
+                auto slot = (wakeup.When >> (SlotBits * level)) & (SlotsPerLevel - 1);
+                _wheel[level][slot].push_back(wakeup);
+                ++_counts[level];
+                return;
+            }
+        }
+        _overflow.push_back(wakeup);
+    }
+
+    void CommandScheduler::tick(vec<EntityHandle> & due) {
+        // Higher levels are cascaded first, since what they hold may land in
+        // the slot of a lower level that is turning over on the same tick
+        uint_ turned = 0;
+        while((turned < Levels) && ((_now & ((static_cast<uint_>(1) << (SlotBits * (turned + 1))) - 1)) == 0)) {
+            ++turned;
+        }
+        if(turned == Levels) {
+            cascade(_overflow);
+        }
+        for(auto level = std::min(turned, Levels - 1); level > 0; --level) {
+            auto & slot = _wheel[level][(_now >> (SlotBits * level)) & (SlotsPerLevel - 1)];
+            _counts[level] -= slot.size();
+            cascade(slot);
+        }
+        auto & slot = _wheel[0][_now & (SlotsPerLevel - 1)];
+        for(auto const& wakeup : slot) {
+            due.push_back(wakeup.Entity);
+        }
+        _counts[0] -= slot.size();
+        slot.clear();
+    }
+
+    void CommandScheduler::cascade(Slot & slot) {
+        Slot moving;
+        moving.swap(slot);
+        for(auto const& wakeup : moving) {
+            place(wakeup);
+        }
+    }
+
+}
@@ -0,0 +1,143 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "EntityHandle.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A reminder to run an entity's controller once a command of it comes due
+    /// </summary>
+    struct CommandWakeup {
+        uint_ When;
+        EntityHandle Entity;
+    };
+
+    /// <summary>
+    /// Returned by CommandScheduler::NextWakeup when nothing is scheduled
+    /// </summary>
+    constexpr uint_ NoWakeup = std::numeric_limits<uint_>::max();
+
+    /// <summary>
+    /// A hierarchical timing wheel of the times at which every controller next has a command due
+    /// </summary>
+    /// <remarks>
+    /// The commands themselves stay in their controllers' queues, which
+    /// still decide what runs and in what order; the wheel only knows which
+    /// entities to look at on which tick. Each level has SlotsPerLevel slots,
+    /// and a slot of level n covers SlotsPerLevel^n ticks. Wakeups are put
+    /// in the lowest level that can tell their tick apart from the current
+    /// one, and are moved down a level each time the wheel turns onto
+    /// their slot, so every wakeup is touched at most once per level.
+    /// Advancing over ticks with nothing due costs nothing per entity, and
+    /// whole turns of empty levels are skipped at once.
+    ///
+    /// Wakeups are never taken back out. A cancelled command just leaves a
+    /// wakeup that finds nothing due, and an entity with several commands
+    /// may be handed out more than once. Scheduling and advancing are
+    /// thread-safe.
+    /// </remarks>
+    class CommandScheduler {
+    public:
+        static constexpr uint_ SlotBits = 6;
+        static constexpr uint_ SlotsPerLevel = static_cast<uint_>(1) << SlotBits;
+        static constexpr uint_ Levels = 4;
+
+    private:
+        using Slot = vec<CommandWakeup>;
+
+        std::mutex _mutex;
+        uint_ _now;
+        std::array<std::array<Slot, SlotsPerLevel>, Levels> _wheel;
+        std::array<uint_, Levels> _counts;
+
+        /// <summary>
+        /// Holds wakeups too far in the future for the top level, looked at again every time it turns over
+        /// </summary>
+        Slot _overflow;
+
+        /// <summary>
+        /// Holds wakeups that were already due when they were scheduled
+        /// </summary>
+        Slot _ready;
+
+        static uptr<CommandScheduler> _instance;
+
+    public:
+        CommandScheduler();
+        CommandScheduler(CommandScheduler const&) = delete;
+        CommandScheduler & operator =(CommandScheduler const&) = delete;
+
+        /// <summary>
+        /// Schedules an entity to be handed out by the Advance that reaches when
+        /// </summary>
+        /// <remarks>
+        /// Times that have already been reached are handed out by the next
+        /// Advance.
+        /// </remarks>
+        void Schedule(EntityHandle entity, uint_ when);
+
+        /// <summary>
+        /// Schedules a batch of wakeups while taking the lock only once
+        /// </summary>
+        void Schedule(vec<CommandWakeup> const& wakeups);
+
+        /// <summary>
+        /// Turns the wheel forward to now and appends every entity that came due on the way to due
+        /// </summary>
+        void Advance(uint_ now, vec<EntityHandle> & due);
+
+        /// <summary>
+        /// Returns the earliest time anything is scheduled for, or NoWakeup iff nothing is
+        /// </summary>
+        /// <remarks>
+        /// Wakeups that are already due give the wheel's current time. This
+        /// walks at most one turn of each level plus the slot it stops at.
+        /// </remarks>
+        uint_ NextWakeup();
+
+        /// <summary>
+        /// Returns the last time the wheel was advanced to
+        /// </summary>
+        uint_ Now();
+
+        /// <summary>
+        /// Returns the number of wakeups that have not been handed out yet
+        /// </summary>
+        uint_ Size();
+
+        /// <summary>
+        /// Drops every wakeup and sets the wheel's time
+        /// </summary>
+        void Reset(uint_ now = 0);
+
+        static ptr<CommandScheduler> Get();
+
+    private:
+        void place(CommandWakeup const& wakeup);
+        void tick(vec<EntityHandle> & due);
+        void cascade(Slot & slot);
+    };
+
+}
@@ -23,35 +23,48 @@
 #include "Components.hpp"
 #include "Game.hpp"
 #include "IEntity.hpp"
+#include "CommandScheduler.hpp"
 
 namespace gquest::components {
 
+    constexpr idtype Name::TypeId;
+
     idtype Name::GetId() const {
-        return L"Name"_id;
+        return TypeId;
     }
 
-    Name::Name(IEntity * parent) : IComponent(parent), _name() { }
+    Name::Name(IEntity * parent) : IComponent(parent), _name(EmptySymbol) { }
+
+    Name::Name(string const & name, IEntity * parent) : IComponent(parent), _name(StringTable::Get()->Intern(name)) { }
 
-    Name::Name(string const & name, IEntity * parent) : IComponent(parent), _name(name) { }
+    Name::Name(Name const & name) : IComponent(name), _name(name._name) { }
 
-    Name::Name(Name const & name) : IComponent(name._parent), _name(name._name) { }
+    string const & Name::GetName() const {
+        return StringTable::Get()->Lookup(_name);
+    }
 
-    string const & Name::GetName() {
+    symbol Name::GetSymbol() const {
         return _name;
     }
 
     void Name::SetName(string const & name) {
+        _name = StringTable::Get()->Intern(name);
+    }
+
+    void Name::SetName(symbol name) {
         _name = name;
     }
 
 
+    vec<PositionChangedEventHandlerPtr> Position::_positionChangedHandlers;
+
     Position::Position(IEntity * parent) : IComponent(parent), _currentSystem(0), _currentSystemPosition(), _inSystem(false) { }
 
     Position::Position(sysid currentSystem, IVector2 const & systemPosition, bool inSystem, IEntity * parent) :
         IComponent(parent), _currentSystem(currentSystem), _currentSystemPosition(systemPosition), _inSystem(inSystem) { }
 
     Position::Position(Position const& position) :
-        IComponent(position._parent),
+        IComponent(position),
         _currentSystem(position._currentSystem),
         _currentSystemPosition(position._currentSystemPosition),
         _inSystem(position._inSystem) { }
@@ -70,27 +83,57 @@ namespace gquest::components {
 
     void Position::SetCurrentSystem(sysid system) {
         _currentSystem = system;
+        markChanged(ComponentSlot<Position>());
     }
 
     void Position::SetPosition(IVector2 const & position) {
         _currentSystemPosition = position;
+        positionChanged();
     }
 
     void Position::SetPosition(int_ x, int_ y) {
         _currentSystemPosition.X = x;
         _currentSystemPosition.Y = y;
+        positionChanged();
     }
 
     void Position::SetIsInSystem(bool inSystem) {
         _inSystem = inSystem;
+        markChanged(ComponentSlot<Position>());
     }
 
+    void Position::AddPositionChangedHandler(PositionChangedEventHandlerPtr handler) {
+        auto iter = std::find(std::begin(_positionChangedHandlers), std::end(_positionChangedHandlers), handler);
+        if(iter != std::end(_positionChangedHandlers)) { return; }
+        _positionChangedHandlers.push_back(handler);
+    }
+
+    void Position::RemovePositionChangedHandler(PositionChangedEventHandlerPtr handler) {
+        auto iter = std::find(std::begin(_positionChangedHandlers), std::end(_positionChangedHandlers), handler);
+        if(iter == std::end(_positionChangedHandlers)) { return; }
+        _positionChangedHandlers.erase(iter);
+    }
+
+    void Position::positionChanged() {
+        markChanged(ComponentSlot<Position>());
+        if(_parent == nullptr) {
+            return;
+        }
+        for(auto const& handler : _positionChangedHandlers) {
+            (*handler)(_parent, _currentSystemPosition);
+        }
+    }
+
+    constexpr idtype Position::TypeId;
+
     idtype Position::GetId() const {
-        return "Position"_id;
+        return TypeId;
     }
 
+    constexpr idtype Cell::TypeId;
+
     idtype Cell::GetId() const {
-        return "Cell"_id;
+        return TypeId;
     }
 
     Cell::Cell(IEntity * parent) : IComponent(parent), _ch{L' ', Attr::FgWhite} { }
@@ -99,7 +142,7 @@ namespace gquest::components {
 
     Cell::Cell(CChar ch, IEntity * parent) : IComponent(parent), _ch(ch) { }
 
-    Cell::Cell(Cell const & cell) : IComponent(cell._parent), _ch(cell._ch) { }
+    Cell::Cell(Cell const & cell) : IComponent(cell), _ch(cell._ch) { }
 
     CChar Cell::GetCChar() const {
         return _ch;
@@ -115,76 +158,82 @@ namespace gquest::components {
 
     void Cell::SetCChar(CChar ch) {
         _ch = ch;
+        markChanged(ComponentSlot<Cell>());
     }
 
     void Cell::SetChar(wchar_t ch) {
         _ch.Char.UnicodeChar = ch;
+        markChanged(ComponentSlot<Cell>());
     }
 
     void Cell::SetAttr(Attr attr) {
         _ch.Attributes = attr;
+        markChanged(ComponentSlot<Cell>());
+    }
+
+    IController::IController(IEntity * parent, bool scheduled) : IComponent(parent), _scheduled(scheduled) { }
+
+    CommandHandle IController::PushCommand(Command const & command) {
+        auto handle = _commands.Push(command);
+        if(_scheduled && (_parent != nullptr) && _parent->GetHandle().IsValid()) {
+            CommandScheduler::Get()->Schedule(_parent->GetHandle(), command.GetWhen());
+        }
+        return handle;
     }
 
-    IController::IController(IEntity * parent) : IComponent(parent) { }
+    CommandHandle IController::PushCommand(Command const & command, vec<CommandWakeup> & wakeups) {
+        auto handle = _commands.Push(command);
+        if(_scheduled && (_parent != nullptr) && _parent->GetHandle().IsValid()) {
+            wakeups.push_back(CommandWakeup{ command.GetWhen(), _parent->GetHandle() });
+        }
+        return handle;
+    }
 
-    void IController::PushCommand(Command const & command) {
-        _commands.push(command);
+    void IController::ScheduleWakeup() {
+        if(_scheduled && !_commands.Empty() && (_parent != nullptr) && _parent->GetHandle().IsValid()) {
+            CommandScheduler::Get()->Schedule(_parent->GetHandle(), _commands.Top().GetWhen());
+        }
     }
 
     Command const & IController::GetTopCommand() const {
-        return _commands.top();
+        return _commands.Top();
     }
 
     Command IController::PopCommand() {
-        auto cmd = _commands.top();
-        _commands.pop();
-        return cmd;
+        return _commands.Pop();
     }
 
     bool IController::CommandsAvailable() const {
-        return !_commands.empty();
+        return !_commands.Empty();
     }
 
     void IController::ClearCommands() {
-        while(!_commands.empty()) {
-            _commands.pop();
-        }
+        _commands.Clear();
     }
 
     void IController::CancelCommandsSoonerThan(uint_ when) {
-        while(!_commands.empty()) {
-            if(_commands.top().GetWhen() < when) {
-                _commands.pop();
-            } else {
-                break;
-            }
-        }
+        _commands.CancelSoonerThan(when);
     }
 
     void IController::CancelCommandsLaterThan(uint_ when) {
-        apqueue<Command> tmpq;
-        while(!_commands.empty()) {
-            if(_commands.top().GetWhen() > when) {
-                break;
-            } else {
-                tmpq.push(_commands.top());
-                _commands.pop();
-            }
-        }
-        _commands = tmpq;
+        _commands.CancelLaterThan(when);
     }
 
     void IController::CancelCommandsAt(uint_ when) {
-        apqueue<Command> tmpq;
-        while(!_commands.empty()) {
-            if(_commands.top().GetWhen() != when) {
-                tmpq.push(_commands.top());
-                _commands.pop();
-            } else {
-                _commands.pop();
-            }
-        }
-        _commands = tmpq;
+        _commands.CancelAt(when);
+    }
+
+    void IController::CancelCommandsOfType(CommandType type) {
+        _commands.CancelOfType(type);
+    }
+
+    bool IController::CancelCommand(CommandHandle handle) {
+        return _commands.Cancel(handle);
+    }
+
+    void IController::ExecuteCommand() {
+        auto command = PopCommand();
+        CommandHandlerRegistry::Get()->Invoke(_parent, this, command, Game::Get()->Now());
     }
 
     void IController::ExecuteCommandsUntil(uint_ when) {
@@ -198,7 +247,9 @@ namespace gquest::components {
         }
     }
 
-    PlayerController::PlayerController(IEntity * parent) : IController(parent) {
+    void IController::OnCommandFinished(Command const&) { }
+
+    PlayerController::PlayerController(IEntity * parent) : IController(parent, false) {
         auto game = Game::Get();
         _onKeyEvent = KeyEventHandlerPtr(
             new KeyEventHandler(
@@ -226,164 +277,60 @@ namespace gquest::components {
         _canAct = true;
     }
 
+    constexpr idtype PlayerController::TypeId;
+
     idtype PlayerController::GetId() const {
-        return "PlayerController"_id;
+        return TypeId;
     }
 
-    void PlayerController::ExecuteCommand() {
-        auto command = _commands.top();
-        switch(command.GetCommandType()) {
-        case CommandType::MoveDown:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if(posr.Y + 1 < Console::Get()->Height() - 1) {
-                //PlaySoundW(L"data\\sfx_move_001.wav", nullptr, SND_FILENAME);
-                pos->SetPosition(
-                    posr.X,
-                    posr.Y + 1
-                );
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveUp:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if(posr.Y - 1 > 0) {
-                //PlaySoundW(L"data\\sfx_move_001.wav", nullptr, SND_FILENAME);
-                pos->SetPosition(
-                    posr.X,
-                    posr.Y - 1
-                );
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveRight:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if(posr.X + 1 < Console::Get()->Width() - 1) {
-                //PlaySoundW(L"data\\sfx_move_001.wav", nullptr, SND_FILENAME);
-                pos->SetPosition(
-                    posr.X + 1,
-                    posr.Y
-                );
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveLeft:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if(posr.X - 1 > Game::Get()->GetSubConsole1()->Width()) {
+    void PlayerController::OnCommandFinished(Command const&) {
+        ClearAct();
+    }
+
+    void PlayerController::RegisterCommandHandlers(CommandHandlerRegistry & registry) {
+        auto move = [](ptr<IEntity> entity, ptr<IController> controller, Command const& command, uint_) {
+            auto pos = entity->Get<Position>();
+            auto next = pos->GetPosition() + MoveOffset(command.GetCommandType());
+            if(Game::Get()->GetPlayArea().contains(next)) {
                 //PlaySoundW(L"data\\sfx_move_001.wav", nullptr, SND_FILENAME);
-                pos->SetPosition(
-                    posr.X - 1,
-                    posr.Y
-                );
+                pos->SetPosition(next);
             }
-            ClearAct();
-            PopCommand();
-            break;
+            controller->OnCommandFinished(command);
+        };
+        for(auto type : { CommandType::MoveLeft, CommandType::MoveRight, CommandType::MoveUp, CommandType::MoveDown,
+            CommandType::MoveLeftUp, CommandType::MoveLeftDown, CommandType::MoveRightUp, CommandType::MoveRightDown }) {
+            registry.SetHandler(type, move);
         }
-        case CommandType::MoveLeftUp:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if((posr.X - 1 > Game::Get()->GetSubConsole1()->Width()) &&
-                (posr.Y - 1 > 0)) {
-
-                pos->SetPosition(posr.X - 1, posr.Y - 1);
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveRightUp:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if((posr.X + 1 < Console::Get()->Width() - 1) &&
-                (posr.Y - 1 > 0)) {
-
-                pos->SetPosition(posr.X + 1, posr.Y - 1);
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveLeftDown:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if((posr.X - 1 > Game::Get()->GetSubConsole1()->Width()) &&
-                (posr.Y + 1 < Console::Get()->Height() - 1)) {
-
-                pos->SetPosition(posr.X - 1, posr.Y + 1);
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::MoveRightDown:
-        {
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            if((posr.X + 1 < Console::Get()->Width() - 1) &&
-                (posr.Y + 1 < Console::Get()->Height() - 1)) {
-
-                pos->SetPosition(posr.X + 1, posr.Y + 1);
-            }
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::Wait:
+        registry.SetHandler(CommandType::Wait, [](ptr<IEntity>, ptr<IController> controller, Command const& command, uint_) {
             //PlaySoundW(L"SystemStart", nullptr, SND_ALIAS);
-            ClearAct();
-            PopCommand();
-            break;
-        case CommandType::DEBUG_BecomeSmiley:
-        {
-            auto cell = (components::Cell*)(_parent->GetComponent("Cell"_id));
+            controller->OnCommandFinished(command);
+        });
+        registry.SetHandler(CommandType::DEBUG_BecomeSmiley, [](ptr<IEntity> entity, ptr<IController>, Command const&, uint_) {
+            auto cell = entity->Get<Cell>();
             cell->SetChar((wchar_t)u'\x263b');
             cell->SetAttr(Attr::FgLightRed);
-            PopCommand();
-            break;
-        }
-        case CommandType::DEBUG_BecomePlayer:
-        {
-            auto cell = (components::Cell*)(_parent->GetComponent("Cell"_id));
+            // Show the smiley even if the ticks until DEBUG_BecomePlayer pass within one frame
+            Game::Get()->GetRenderScheduler().ForceNextFrame();
+        });
+        registry.SetHandler(CommandType::DEBUG_BecomePlayer, [](ptr<IEntity> entity, ptr<IController> controller, Command const& command, uint_) {
+            auto cell = entity->Get<Cell>();
             cell->SetChar(L'@');
             cell->SetAttr(Attr::FgLightGreen);
-            ClearAct();
-            PopCommand();
-            break;
-        }
-        case CommandType::LivelySplatter_Spawn:
-        {
-            auto args = command.GetArguments();
-            int_ X, Y;
-            auto iter = std::begin(args);
-            (iter++)->get(X);
-            iter->get(Y);
+            controller->OnCommandFinished(command);
+        });
+        registry.SetHandler(CommandType::LivelySplatter_Spawn, [](ptr<IEntity>, ptr<IController>, Command const& command, uint_) {
+            int_ X = 0;
+            int_ Y = 0;
+            // A malformed command, such as one from a damaged log, spawns nothing
+            if(!command.GetArgument(0, X) || !command.GetArgument(1, Y)) {
+                return;
+            }
             Game::Get()->AddEntity(
                 EntityPtr(
                     new LivelySplatterEntity(X, Y)
                 )
             );
-            PopCommand();
-            break;
-        }
-        }
-        
+        });
     }
 
     void PlayerController::onKeyEvent(KEY_EVENT_RECORD const & evt) {
@@ -394,7 +341,7 @@ namespace gquest::components {
             switch(evt.wVirtualKeyCode) {
             case VK_DOWN:
             case VK_NUMPAD2:
-                this->PushCommand(
+                this->submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::MoveDown
@@ -406,7 +353,7 @@ namespace gquest::components {
                 break;
             case VK_UP:
             case VK_NUMPAD8:
-                this->PushCommand(
+                this->submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::MoveUp
@@ -418,7 +365,7 @@ namespace gquest::components {
                 break;
             case VK_RIGHT:
             case VK_NUMPAD6:
-                this->PushCommand(
+                this->submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::MoveRight
@@ -430,7 +377,7 @@ namespace gquest::components {
                 break;
             case VK_LEFT:
             case VK_NUMPAD4:
-                this->PushCommand(
+                this->submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::MoveLeft
@@ -442,7 +389,7 @@ namespace gquest::components {
                 break;
             case VK_DECIMAL:
             case VK_NUMPAD5:
-                this->PushCommand(
+                this->submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::Wait
@@ -452,39 +399,39 @@ namespace gquest::components {
                 Game::Get()->Acted();
                 break;
             case VK_NUMPAD7:
-                this->PushCommand(Command(Game::Get()->Now() + 1, CommandType::MoveLeftUp));
+                this->submit(Command(Game::Get()->Now() + 1, CommandType::MoveLeftUp));
                 trySpawnLivelySplatter();
                 Acted();
                 Game::Get()->Acted();
                 break;
             case VK_NUMPAD9:
-                this->PushCommand(Command(Game::Get()->Now() + 1, CommandType::MoveRightUp));
+                this->submit(Command(Game::Get()->Now() + 1, CommandType::MoveRightUp));
                 trySpawnLivelySplatter();
                 Acted();
                 Game::Get()->Acted();
                 break;
             case VK_NUMPAD1:
-                this->PushCommand(Command(Game::Get()->Now() + 1, CommandType::MoveLeftDown));
+                this->submit(Command(Game::Get()->Now() + 1, CommandType::MoveLeftDown));
                 trySpawnLivelySplatter();
                 Acted();
                 Game::Get()->Acted();
                 break;
             case VK_NUMPAD3:
-                this->PushCommand(Command(Game::Get()->Now() + 1, CommandType::MoveRightDown));
+                this->submit(Command(Game::Get()->Now() + 1, CommandType::MoveRightDown));
                 trySpawnLivelySplatter();
                 Acted();
                 Game::Get()->Acted();
                 break;
             case 'Q':
-                this->PushCommand(Command(Game::Get()->Now(), CommandType::DEBUG_BecomeSmiley));
-                this->PushCommand(Command(Game::Get()->Now() + 19, CommandType::DEBUG_BecomePlayer));
+                this->submit(Command(Game::Get()->Now(), CommandType::DEBUG_BecomeSmiley));
+                this->submit(Command(Game::Get()->Now() + 19, CommandType::DEBUG_BecomePlayer));
                 Acted();
                 Game::Get()->Acted();
                 break;
             case 'W':
             {
-                auto pos = (components::Position*)this->GetParent()->GetComponent("Position"_id);
-                PushCommand(
+                auto pos = this->GetParent()->Get<Position>();
+                submit(
                     Command(
                         Game::Get()->Now(),
                         CommandType::LivelySplatter_Spawn,
@@ -498,7 +445,7 @@ namespace gquest::components {
             }
             default:
                 if(evt.uChar.UnicodeChar == L'.') {
-                    this->PushCommand(
+                    this->submit(
                         Command(
                             Game::Get()->Now(),
                             CommandType::Wait
@@ -514,9 +461,9 @@ namespace gquest::components {
 
     void PlayerController::trySpawnLivelySplatter() {
         const vec<bool> choices = {0,0,0,1};
-        if(Game::Get()->GetRandom().pick(choices)) {
-            auto pos = (components::Position*)this->GetParent()->GetComponent("Position"_id);
-            PushCommand(
+        if(Game::Get()->GetInputRandom().pick(choices)) {
+            auto pos = this->GetParent()->Get<Position>();
+            submit(
                 Command(
                     Game::Get()->Now(),
                     CommandType::LivelySplatter_Spawn,
@@ -527,6 +474,11 @@ namespace gquest::components {
         }
     }
 
+    void PlayerController::submit(Command const& command) {
+        PushCommand(command);
+        Game::Get()->RecordCommand(command);
+    }
+
     LivelySplatterController::LivelySplatterController(IEntity * parent) : IController(parent) {
         PushCommand(
             Command(
@@ -538,69 +490,56 @@ namespace gquest::components {
 
     LivelySplatterController::~LivelySplatterController() { }
 
+    constexpr idtype LivelySplatterController::TypeId;
+
     idtype LivelySplatterController::GetId() const {
-        return "LivelySplatterController"_id;
-    }
-
-    void LivelySplatterController::ExecuteCommand() {
-        auto command = _commands.top();
-        switch(command.GetCommandType()) {
-        case CommandType::LivelySplatter_Move:
-        {
-            const ui64vec dirs = {0, 1, 2, 3};
-            auto game = Game::Get();
-            auto pos = (components::Position*)(_parent->GetComponent("Position"_id));
-            auto posr = pos->GetPosition();
-            uint_ direction = game->GetRandom().pick(dirs);
-            switch(direction) {
-            case 0: // Left
-                if(posr.X - 1 > Game::Get()->GetSubConsole1()->Width()) {
-                    pos->SetPosition(
-                        posr.X - 1,
-                        posr.Y
-                    );
-                }
-                break;
-            case 1: // Up
-                if(posr.Y - 1 > 0) {
-                    pos->SetPosition(
-                        posr.X,
-                        posr.Y - 1
-                    );
-                }
-                break;
-            case 2: // Right
-                if(posr.X + 1 < Console::Get()->Width() - 1) {
-                    pos->SetPosition(
-                        posr.X + 1,
-                        posr.Y
-                    );
-                }
-                break;
-            case 3: // Down
-                if(posr.Y + 1 < Console::Get()->Height() - 1) {
-                    pos->SetPosition(
-                        posr.X,
-                        posr.Y + 1
-                    );
+        return TypeId;
+    }
+
+    void LivelySplatterController::ExecuteMoves(CommandBatch const & batch, uint_) {
+        static IVector2 const steps[] = { IVector2(-1, 0), IVector2(0, -1), IVector2(1, 0), IVector2(0, 1) };
+        auto game = Game::Get();
+        auto const& area = game->GetPlayArea();
+        auto & random = game->GetRandom();
+        auto world = game->GetWorld();
+        vec<ptr<IEntity>> occupants;
+        vec<CommandWakeup> wakeups;
+        wakeups.reserve(batch.size());
+        // Only LivelySplatterEntities have this controller, and they mostly
+        // share an archetype, so positions are read straight out of its column
+        ptr<Archetype> archetype = nullptr;
+        vec<Position> * positions = nullptr;
+        for(auto const& due : batch) {
+            auto entity = static_cast<ptr<LivelySplatterEntity>>(due.Entity);
+            if(entity->GetArchetype() != archetype) {
+                archetype = entity->GetArchetype();
+                positions = archetype->GetValues<Position>(Position::TypeId);
+            }
+            auto & pos = (positions != nullptr) ? (*positions)[entity->GetRow()] : *entity->Get<Position>();
+            auto next = pos.GetPosition() + random.pick(steps);
+            if(area.contains(next)) {
+                // Splatters don't pile up: the step is only taken into a cell nothing else is in
+                occupants.clear();
+                world->QueryEntitiesAt(next, occupants, pos.GetCurrentSystem());
+                if(occupants.empty()) {
+                    pos.SetPosition(next);
                 }
-                break;
             }
-
-            PopCommand();
-
-            // Cause another move in the future
-            PushCommand(
+            // Cause another move in the future, counted from when this one was due rather than
+            // from now, which may be later when the system is caught up in coarse steps
+            due.Controller->PushCommand(
                 Command(
-                    Game::Get()->Now() + Game::Get()->GetRandom().uniform(1, 10),
+                    due.Cmd.GetWhen() + random.uniform(1, 10),
                     CommandType::LivelySplatter_Move
-                )
+                ),
+                wakeups
             );
-
-            break;
         }
-        }
-        
+        CommandScheduler::Get()->Schedule(wakeups);
+    }
+
+    void LivelySplatterController::RegisterCommandHandlers(CommandHandlerRegistry & registry) {
+        registry.SetBatchHandler(CommandType::LivelySplatter_Move, &LivelySplatterController::ExecuteMoves);
     }
 
 }
@@ -23,34 +23,53 @@
 
 #include "GalactiQuestBase.hpp"
 #include "IComponent.hpp"
+#include "Pool.hpp"
+#include "StringTable.hpp"
 #include "Vector2.hpp"
 #include "Command.hpp"
+#include "CommandQueue.hpp"
+#include "CommandScheduler.hpp"
+#include "CommandBatch.hpp"
+#include "CommandHandlers.hpp"
 #include "EventHandler.hpp"
 
 namespace gquest::components {
 
-    class Name : public IComponent {
+    /// <summary>
+    /// The name of an entity, kept as a symbol in the StringTable so entities with the same name share it
+    /// </summary>
+    class Name : public IComponent, public Pooled<Name> {
+    public:
+        static constexpr idtype TypeId = L"Name"_id;
+
     private:
-        string _name;
+        symbol _name;
 
     public:
         Name(IEntity * parent=nullptr);
         Name(string const& name, IEntity * parent = nullptr);
         Name(Name const& name);
 
-        string const& GetName();
+        string const& GetName() const;
+        symbol GetSymbol() const;
         void SetName(string const& name);
+        void SetName(symbol name);
 
         // Inherited via IComponent
         virtual idtype GetId() const override;
     };
 
-    class Position : public IComponent {
+    class Position : public IComponent, public Pooled<Position> {
+    public:
+        static constexpr idtype TypeId = "Position"_id;
+
     private:
         sysid _currentSystem;
         IVector2 _currentSystemPosition;
         bool _inSystem;
 
+        static vec<PositionChangedEventHandlerPtr> _positionChangedHandlers;
+
     public:
         Position(IEntity * parent = nullptr);
         Position(sysid currentSystem, IVector2 const& systemPosition, bool inSystem, IEntity * parent = nullptr);
@@ -64,11 +83,23 @@ namespace gquest::components {
         void SetPosition(int_ x, int_ y);
         void SetIsInSystem(bool inSystem);
 
+        /// <summary>
+        /// Adds a handler that is called with the parent entity and new position whenever SetPosition is called
+        /// </summary>
+        static void AddPositionChangedHandler(PositionChangedEventHandlerPtr handler);
+        static void RemovePositionChangedHandler(PositionChangedEventHandlerPtr handler);
+
         // Inherited via IComponent
         virtual idtype GetId() const override;
+
+    private:
+        void positionChanged();
     };
 
-    class Cell : public IComponent {
+    class Cell : public IComponent, public Pooled<Cell> {
+    public:
+        static constexpr idtype TypeId = "Cell"_id;
+
     private:
         CChar _ch;
 
@@ -92,12 +123,39 @@ namespace gquest::components {
 
     class IController : public IComponent {
     protected:
-        apqueue<Command> _commands;
+        CommandQueue _commands;
 
-    public:
-        IController(IEntity * parent = nullptr);
+        /// <summary>
+        /// Whether pushed commands are put on the CommandScheduler, rather than the controller being run by hand every tick
+        /// </summary>
+        bool _scheduled;
 
-        virtual void PushCommand(Command const& command);
+    public:
+        IController(IEntity * parent = nullptr, bool scheduled = true);
+
+        /// <summary>
+        /// Queues a command and returns a handle that can cancel it until it runs
+        /// </summary>
+        virtual CommandHandle PushCommand(Command const& command);
+
+        /// <summary>
+        /// Queues a command like PushCommand, but leaves its wakeup in wakeups for the caller to schedule
+        /// </summary>
+        /// <remarks>
+        /// For batch handlers, which push a command for every controller in
+        /// the batch and then schedule all of their wakeups under one lock.
+        /// </remarks>
+        CommandHandle PushCommand(Command const& command, vec<CommandWakeup> & wakeups);
+
+        /// <summary>
+        /// Puts the next command on the CommandScheduler iff there is one and the entity has a handle
+        /// </summary>
+        /// <remarks>
+        /// PushCommand does this on its own, so this is only needed for
+        /// commands pushed before the entity was registered, or whose
+        /// wakeups were dropped while its system was dormant.
+        /// </remarks>
+        void ScheduleWakeup();
         virtual Command const& GetTopCommand() const;
         virtual Command PopCommand();
         virtual bool CommandsAvailable() const;
@@ -105,11 +163,29 @@ namespace gquest::components {
         virtual void CancelCommandsSoonerThan(uint_ when);
         virtual void CancelCommandsLaterThan(uint_ when);
         virtual void CancelCommandsAt(uint_ when);
-        virtual void ExecuteCommand() = 0;
+        virtual void CancelCommandsOfType(CommandType type);
+
+        /// <summary>
+        /// Cancels a command iff it is still queued, returning true iff it was
+        /// </summary>
+        virtual bool CancelCommand(CommandHandle handle);
+
+        /// <summary>
+        /// Pops the next command and runs it through the CommandHandlerRegistry, dropping it iff its type has no handler
+        /// </summary>
+        virtual void ExecuteCommand();
         virtual void ExecuteCommandsUntil(uint_ when);
+
+        /// <summary>
+        /// Called by a command handler once the action started by the command is complete; does nothing by default
+        /// </summary>
+        virtual void OnCommandFinished(Command const& command);
     };
 
-    class PlayerController : public IController {
+    class PlayerController : public IController, public Pooled<PlayerController> {
+    public:
+        static constexpr idtype TypeId = "PlayerController"_id;
+
     private:
         KeyEventHandlerPtr _onKeyEvent;
         bool _canAct;
@@ -121,25 +197,50 @@ namespace gquest::components {
         void Acted();
         void ClearAct();
 
+        /// <summary>
+        /// Registers the handlers of the commands the player's input queues
+        /// </summary>
+        static void RegisterCommandHandlers(CommandHandlerRegistry & registry);
+
         // Inherited via IController
         virtual idtype GetId() const override;
-        virtual void ExecuteCommand() override;
+
+        /// <summary>
+        /// Lets the player act again
+        /// </summary>
+        virtual void OnCommandFinished(Command const& command) override;
 
     private:
         void onKeyEvent(KEY_EVENT_RECORD const& evt);
 
         void trySpawnLivelySplatter();
+
+        /// <summary>
+        /// Queues a command from the player's input, and adds it to the InputLog being recorded
+        /// </summary>
+        void submit(Command const& command);
     };
 
-    class LivelySplatterController : public IController {
+    class LivelySplatterController : public IController, public Pooled<LivelySplatterController> {
+    public:
+        static constexpr idtype TypeId = "LivelySplatterController"_id;
+
     public:
         LivelySplatterController(IEntity * parent = nullptr);
         ~LivelySplatterController();
 
+        /// <summary>
+        /// Moves every splatter in a batch of LivelySplatter_Move commands a step in a random direction and queues its next move
+        /// </summary>
+        static void ExecuteMoves(CommandBatch const& batch, uint_ now);
+
+        /// <summary>
+        /// Registers ExecuteMoves as the batch handler of LivelySplatter_Move
+        /// </summary>
+        static void RegisterCommandHandlers(CommandHandlerRegistry & registry);
+
         // Inherited via IController
         virtual idtype GetId() const override;
-        virtual void ExecuteCommand() override;
-
     };
 
 }
@@ -687,31 +687,50 @@ namespace conlib {
 
     INPUT_RECORD Console::WaitForEvent() {
         INPUT_RECORD evt;
+        while(!WaitForEvent(evt, INFINITE)) { }
+        return evt;
+    }
+
+    bool Console::WaitForEvent(INPUT_RECORD & newEvent, DWORD timeout_ms) {
+        auto hIn = GetStdHandle(STD_INPUT_HANDLE);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
         for(;;) {
-            while(GetEvent(evt)) {
-                return evt;
+            if(GetEvent(newEvent)) {
+                return true;
+            }
+            DWORD wait = timeout_ms;
+            if(timeout_ms != INFINITE) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                wait = (left > 0) ? static_cast<DWORD>(left) : 0;
+            }
+            // The input handle is signalled while there is unread input, so this sleeps until a key is pressed
+            auto result = WaitForSingleObject(hIn, wait);
+            if(result == WAIT_FAILED) {
+                // The handle can't be waited on (input may be redirected), so poll 15 times a second rather than spin
+                if(wait == 0) {
+                    return GetEvent(newEvent);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::min<DWORD>(wait, 1000 / 15)));
+                continue;
+            }
+            if(result != WAIT_OBJECT_0) {
+                return GetEvent(newEvent);
             }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long>(1000.0 / 15.0)));
         }
     }
 
     void Console::WaitForKey(unsigned int virtualKeyCode) {
-        INPUT_RECORD evt;
         for(;;) {
-            while(GetEvent(evt)) {
-                switch(evt.EventType) {
-                case KEY_EVENT:
-                    if(evt.Event.KeyEvent.bKeyDown) {
-                        if(evt.Event.KeyEvent.wVirtualKeyCode == virtualKeyCode) {
-                            return;
-                        }
+            auto evt = WaitForEvent();
+            switch(evt.EventType) {
+            case KEY_EVENT:
+                if(evt.Event.KeyEvent.bKeyDown) {
+                    if(evt.Event.KeyEvent.wVirtualKeyCode == virtualKeyCode) {
+                        return;
                     }
-                    break;
                 }
+                break;
             }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long>(1000.0 / 15.0)));
         }
     }
 
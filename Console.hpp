@@ -127,6 +127,9 @@ namespace conlib {
         int NumberOfEvents() const;
         template<class PushBackableContainer_INPUT_RECORD> void GetEvents(PushBackableContainer_INPUT_RECORD & events, unsigned int max_events);
         INPUT_RECORD WaitForEvent();
+
+        // Blocks on the input handle, without polling, until there is an event or timeout_ms have passed (INFINITE waits forever)
+        bool WaitForEvent(INPUT_RECORD & newEvent, DWORD timeout_ms);
         void WaitForKey(unsigned int virtualKeyCode);
         void WaitForEnter();
     };
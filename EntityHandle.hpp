@@ -0,0 +1,82 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A reference to an entity in the EntityRegistry made of a slot index and a generation
+    /// </summary>
+    /// <remarks>
+    /// Every time a slot is released its generation goes up, so a handle
+    /// that outlives its entity can never resolve to whatever takes the
+    /// slot over next.
+    /// </remarks>
+    class EntityHandle {
+    private:
+        ui64 _value;
+
+    public:
+        static constexpr ui32 InvalidIndex = 0xFFFFFFFFu;
+
+        constexpr EntityHandle() : _value(static_cast<ui64>(InvalidIndex)) { }
+        constexpr EntityHandle(ui32 index, ui32 generation) :
+            _value((static_cast<ui64>(generation) << 32) | static_cast<ui64>(index)) { }
+
+        inline constexpr ui32 GetIndex() const { return static_cast<ui32>(_value & 0xFFFFFFFFull); }
+        inline constexpr ui32 GetGeneration() const { return static_cast<ui32>(_value >> 32); }
+        inline constexpr ui64 GetValue() const { return _value; }
+        inline constexpr bool IsValid() const { return GetIndex() != InvalidIndex; }
+
+        friend constexpr bool operator ==(EntityHandle const& lhs, EntityHandle const& rhs);
+        friend constexpr bool operator !=(EntityHandle const& lhs, EntityHandle const& rhs);
+        friend constexpr bool operator <(EntityHandle const& lhs, EntityHandle const& rhs);
+    };
+
+    inline constexpr bool operator ==(EntityHandle const& lhs, EntityHandle const& rhs) {
+        return lhs._value == rhs._value;
+    }
+    inline constexpr bool operator !=(EntityHandle const& lhs, EntityHandle const& rhs) {
+        return lhs._value != rhs._value;
+    }
+    inline constexpr bool operator <(EntityHandle const& lhs, EntityHandle const& rhs) {
+        return lhs._value < rhs._value;
+    }
+
+    constexpr EntityHandle InvalidEntity = EntityHandle();
+
+    using EntityHandleList = vec<EntityHandle>;
+    using EntityHandleMap = map<sysid, EntityHandleList>;
+
+}
+
+namespace std {
+
+    template <> struct hash<gquest::EntityHandle> {
+        inline size_t operator ()(gquest::EntityHandle const& handle) const {
+            return hash<gquest::ui64>()(handle.GetValue());
+        }
+    };
+
+}
@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "EntityRegistry.hpp"
+
+namespace gquest {
+
+    namespace {
+        EntityPtr const NoEntity = nullptr;
+    }
+
+    uptr<EntityRegistry> EntityRegistry::_instance = nullptr;
+
+    EntityRegistry::EntityRegistry() : _alive(0) { }
+
+    EntityHandle EntityRegistry::Register(EntityPtr const & entity) {
+        if(entity == nullptr) {
+            return InvalidEntity;
+        }
+        auto existing = entity->GetHandle();
+        if(Resolve(existing) == entity.get()) {
+            return existing;
+        }
+        ui32 index;
+        if(!_free.empty()) {
+            index = _free.back();
+            _free.pop_back();
+        } else {
+            index = static_cast<ui32>(_slots.size());
+            _slots.push_back(Slot{nullptr, 0});
+        }
+        auto & slot = _slots[index];
+        slot.Entity = entity;
+        auto handle = EntityHandle(index, slot.Generation);
+        entity->SetHandle(handle);
+        ++_alive;
+        return handle;
+    }
+
+    bool EntityRegistry::Release(EntityHandle handle) {
+        if(!IsAlive(handle)) {
+            return false;
+        }
+        auto & slot = _slots[handle.GetIndex()];
+        slot.Entity->SetHandle(InvalidEntity);
+        _released.push_back(std::move(slot.Entity));
+        slot.Entity = nullptr;
+        ++slot.Generation;
+        _free.push_back(handle.GetIndex());
+        --_alive;
+        return true;
+    }
+
+    void EntityRegistry::Collect() {
+        // Destroying an entity may release others, so swap the list out first
+        while(!_released.empty()) {
+            vec<EntityPtr> released;
+            released.swap(_released);
+            released.clear();
+        }
+    }
+
+    bool EntityRegistry::IsAlive(EntityHandle handle) const {
+        return Resolve(handle) != nullptr;
+    }
+
+    EntityPtr const & EntityRegistry::ResolveShared(EntityHandle handle) const {
+        if(Resolve(handle) == nullptr) {
+            return NoEntity;
+        }
+        return _slots[handle.GetIndex()].Entity;
+    }
+
+    uint_ EntityRegistry::Size() const {
+        return _alive;
+    }
+
+    ptr<EntityRegistry> EntityRegistry::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<EntityRegistry>(new EntityRegistry());
+        }
+        return _instance.get();
+    }
+
+}
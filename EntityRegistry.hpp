@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "EntityHandle.hpp"
+#include "IEntity.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// The central table that owns every entity and hands out EntityHandles to them
+    /// </summary>
+    /// <remarks>
+    /// Released entities are not destroyed straight away. Their handles go
+    /// stale immediately, but the entities themselves are kept alive until
+    /// Collect() is called, so anything still using them in the middle of
+    /// a tick is not left holding a dangling reference.
+    ///
+    /// Registering and releasing are not thread-safe; resolving handles is,
+    /// as long as nothing is being registered or released at the same time.
+    /// </remarks>
+    class EntityRegistry {
+    private:
+        struct Slot {
+            EntityPtr Entity;
+            ui32 Generation;
+        };
+
+        /// <remarks>
+        /// A deque so that growing it never moves the slots, which keeps the
+        /// references handed out by ResolveShared() valid while callbacks
+        /// register new entities.
+        /// </remarks>
+        std::deque<Slot> _slots;
+        vec<ui32> _free;
+        vec<EntityPtr> _released;
+        uint_ _alive;
+
+        static uptr<EntityRegistry> _instance;
+    public:
+        EntityRegistry();
+        EntityRegistry(EntityRegistry const&) = delete;
+        EntityRegistry & operator =(EntityRegistry const&) = delete;
+
+        /// <summary>
+        /// Takes a share of an entity and returns its handle, or its existing handle iff it is already registered
+        /// </summary>
+        EntityHandle Register(EntityPtr const& entity);
+
+        /// <summary>
+        /// Makes a handle stale and lets go of the entity at the next Collect() iff the handle is alive
+        /// </summary>
+        bool Release(EntityHandle handle);
+
+        /// <summary>
+        /// Destroys the entities released since the last call, unless something else still shares them
+        /// </summary>
+        void Collect();
+
+        bool IsAlive(EntityHandle handle) const;
+
+        /// <summary>
+        /// Returns the entity a handle refers to, or nullptr iff the handle is stale
+        /// </summary>
+        inline ptr<IEntity> Resolve(EntityHandle handle) const {
+            auto index = handle.GetIndex();
+            if((index < _slots.size()) && (_slots[index].Generation == handle.GetGeneration())) {
+                return _slots[index].Entity.get();
+            }
+            return nullptr;
+        }
+
+        /// <summary>
+        /// Returns the shared pointer a handle refers to, or an empty one iff the handle is stale
+        /// </summary>
+        /// <remarks>
+        /// This exists for code that still works with EntityPtr. The
+        /// reference stays valid until the handle is released.
+        /// </remarks>
+        EntityPtr const& ResolveShared(EntityHandle handle) const;
+
+        /// <summary>
+        /// Returns the number of live entities
+        /// </summary>
+        uint_ Size() const;
+
+        static ptr<EntityRegistry> Get();
+    };
+
+}
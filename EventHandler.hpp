@@ -22,14 +22,19 @@
 #pragma once
 
 #include "GalactiQuestBase.hpp"
+#include "Vector2.hpp"
 
 namespace gquest {
 
+    class IEntity;
+
     using KeyEventHandler = function<void(KEY_EVENT_RECORD const&)>;
     using MouseEventHandler = function<void(MOUSE_EVENT_RECORD const&)>;
     using ExitGameEventHandler = function<void(void)>;
+    using PositionChangedEventHandler = function<void(ptr<IEntity>, IVector2 const&)>;
     using KeyEventHandlerPtr = sptr<KeyEventHandler>;
     using MouseEventHandlerPtr = sptr<MouseEventHandler>;
     using ExitGameEventHandlerPtr = sptr<ExitGameEventHandler>;
+    using PositionChangedEventHandlerPtr = sptr<PositionChangedEventHandler>;
 
 }
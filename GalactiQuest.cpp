@@ -22,11 +22,39 @@
 
 #include "stdafx.h"
 #include "Game.hpp"
+#include "CommandHandlers.hpp"
 
 int wmain(int argc, wchar_t * argv[]) {
     using namespace gquest;
     {
         auto game = uptr<Game>(Game::Get());
+        if((argc == 3) && (string(argv[1]) == L"--replay")) {
+            try {
+                auto result = game->Replay(InputLog::Read(argv[2]));
+                std::wcout << result.Frames << L" frames, " << result.Ticks << L" ticks in " << result.Seconds << L"s, "
+                    << result.ChecksumsMatched << L" checksums matched" << std::endl;
+                auto handlers = CommandHandlerRegistry::Get();
+                for(uint_ index = 0; index < CommandTypeCount; ++index) {
+                    auto type = static_cast<CommandType>(index);
+                    auto stats = handlers->GetStats(type);
+                    if(stats.Calls != 0) {
+                        std::wcout << L"  " << CommandTypeName(type) << L": " << stats.Calls << L" calls, "
+                            << (stats.Nanoseconds / 1000) << L"us" << std::endl;
+                    }
+                }
+                if(result.Diverged) {
+                    std::wcout << L"Diverged from the log at tick " << result.DivergedAt << std::endl;
+                    return 1;
+                }
+            } catch(std::runtime_error const& e) {
+                std::wcerr << e.what() << std::endl;
+                return 2;
+            }
+            return 0;
+        }
+        if((argc == 3) && (string(argv[1]) == L"--record")) {
+            game->StartRecording(argv[2]);
+        }
         game->Run();
     }
     return 0;
@@ -154,6 +154,14 @@ namespace gquest {
 
     template <class KeyType, class ValueType> using map = std::map<KeyType, ValueType>;
 
+    // Hash Mapping Type
+
+    template <class KeyType, class ValueType> using hashmap = std::unordered_map<KeyType, ValueType>;
+
+    // Hash Set Type
+
+    template <class Type> using hashset = std::unordered_set<Type>;
+
     // Queue Type
 
     template <class Type> using queue = std::queue<Type>;
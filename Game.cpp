@@ -22,13 +22,44 @@
 
 #include "stdafx.h"
 #include "Game.hpp"
+#include "CommandScheduler.hpp"
+#include "SimulationSystems.hpp"
 
 namespace gquest {
 
     ptr<Game> Game::_instance = nullptr;
 
-    Game::Game() { }
+    namespace {
+
+        inline ui64 fnv1a(ui64 hash, ui64 value) {
+            for(int i = 0; i < 8; ++i) {
+                hash ^= (value >> (i * 8)) & 0xFF;
+                hash *= 0x100000001B3ull;
+            }
+            return hash;
+        }
+
+    }
+
+    Game::Game() :
+        _drawnSystem(World::NoSystem), _redrawAll(true), _skipIdleTicks(false), _headless(false),
+        _checksumInterval(DEFAULT_CHECKSUM_INTERVAL), _nextChecksum(0) {
+        Seed(std::random_device{}());
+    }
     Game::~Game() {
+        RemoveAllEntities();
+        if(_player != nullptr) {
+            _world.RemoveEntity(_player);
+            EntityRegistry::Get()->Release(_player->GetHandle());
+            _player.reset();
+        }
+        EntityRegistry::Get()->Collect();
+        if(_instance == this) {
+            _instance = nullptr;
+        }
+        if(_headless) {
+            return;
+        }
         auto console = Console::Get();
         console->SetCursorVisible(this->_oldCursorVisible);
         //console->SetPalette(default_palette);
@@ -47,14 +78,15 @@ namespace gquest {
         //this->_playerX = GAME_WIDTH / 2;
         //this->_playerY = GAME_HEIGHT / 2;
 
-        this->_time = 0;
-        this->_actionPerformed = false;
-
         KeyEventHandlerPtr baseKeyEventHandler = KeyEventHandlerPtr(new KeyEventHandler([&](KEY_EVENT_RECORD const& evt) { this->BaseKeyEventHandler(evt); }));
         this->AddKeyEventHandler(baseKeyEventHandler);
 
-        this->_player = uptr<PlayerEntity>(new PlayerEntity(GAME_WIDTH / 2, GAME_HEIGHT / 2));
-        this->_entities = { };
+        this->setUp(IRect(
+            this->_subcon1->Width() + 1, 1,
+            console->Width() - this->_subcon1->Width() - 2, console->Height() - 2
+        ));
+
+        this->startRecorder();
 
         this->_running = true;
         this->Render();
@@ -65,6 +97,8 @@ namespace gquest {
         }
         HandleExitGameEvent();
 
+        this->_onChecksum = nullptr;
+        this->_recorder.reset();
         this->RemoveKeyEventHandler(baseKeyEventHandler);
     }
     void Game::Render() {
@@ -74,7 +108,7 @@ namespace gquest {
         this->_subcon1->Fill(1, 1, this->_subcon1->Width() - 2, this->_subcon1->Height() - 2, L' ', Attr::FgWhite | Attr::BgBlue);
         this->_subcon1->Box(0, 0, this->_subcon1->Width(), this->_subcon1->Height(), Attr::FgLightCyan | Attr::BgBlue);
         {
-            auto p_pos = (components::Position*)(this->_player->GetComponent("Position"_id));
+            auto p_pos = this->_player->Get<components::Position>();
             this->_subcon1->PutString(1, 1, L"T: " + ToString(_time), Attr::FgWhite | Attr::BgBlue, this->_subcon1->Width() - 2);
             this->_subcon1->PutString(1, 2, L"X: " + ToString(p_pos->GetPosition().X), Attr::FgWhite | Attr::BgBlue, this->_subcon1->Width() - 2);
             this->_subcon1->PutString(1, 3, L"Y: " + ToString(p_pos->GetPosition().Y), Attr::FgWhite | Attr::BgBlue, this->_subcon1->Width() - 2);
@@ -82,25 +116,19 @@ namespace gquest {
         }
         //this->_subcon1->PutString(1, 1, L"X: " + ToString(this->_playerX), Attr::FgWhite | Attr::BgBlue, this->_subcon1->Width() - 2);
         //this->_subcon1->PutString(1, 2, L"Y: " + ToString(this->_playerY), Attr::FgWhite | Attr::BgBlue, this->_subcon1->Width() - 2);
-        console->Clear(L'.', Attr::FgGrey);
-        console->Fill(1, 1, GAME_WIDTH - 2, GAME_HEIGHT - 2, L'.', Attr::FgGrey);
-        console->Box(this->_subcon1->Width(), 0, GAME_WIDTH - this->_subcon1->Width(), GAME_HEIGHT, Attr::FgLightGrey);
         { // Draw entities
-            for(auto entity : _entities) {
-                if(
-                    entity->HasComponentOfType("Cell"_id) &&
-                    entity->HasComponentOfType("Position"_id)
-                    ) {
-
-                    auto epos = (components::Position*)(entity->GetComponent("Position"_id));
-                    auto ecell = (components::Cell*)(entity->GetComponent("Cell"_id));
-                    console->SetChar(epos->GetPosition().X, epos->GetPosition().Y, ecell->GetCChar());
-                }
+            auto system_id = this->_player->Get<components::Position>()->GetCurrentSystem();
+            // Past a point, finding the cells to redraw costs more than redrawing the map
+            if(_redrawAll || (system_id != _drawnSystem) || (_changes.GetChanges().size() > _drawnAt.size())) {
+                drawMap(system_id);
+            } else {
+                drawChanges(system_id);
             }
+            _changes.Clear();
         }
         { // Draw player
-            auto p_pos = (components::Position*)(this->_player->GetComponent("Position"_id));
-            auto p_cell = (components::Cell*)(this->_player->GetComponent("Cell"_id));
+            auto p_pos = this->_player->Get<components::Position>();
+            auto p_cell = this->_player->Get<components::Cell>();
             console->SetChar(p_pos->GetPosition().X, p_pos->GetPosition().Y, p_cell->GetCChar());
         }
         //console->SetChar(this->_playerX, this->_playerY, L'@', Attr::FgLightGreen);
@@ -110,26 +138,83 @@ namespace gquest {
 
         console->Display();
     }
-    void Game::Update() {
-        auto p_controller = (components::PlayerController*)(_player->GetComponent("PlayerController"_id));
-        _actionPerformed = false;
-        HandleEvents();
-        do {
-            p_controller->ExecuteCommandsUntil(_time);
+    void Game::drawMap(sysid system_id) {
+        auto console = Console::Get();
+        console->Clear(L'.', Attr::FgGrey);
+        console->Fill(1, 1, GAME_WIDTH - 2, GAME_HEIGHT - 2, L'.', Attr::FgGrey);
+        console->Box(this->_subcon1->Width(), 0, GAME_WIDTH - this->_subcon1->Width(), GAME_HEIGHT, Attr::FgLightGrey);
+        _background.resize(console->Width() * console->Height());
+        for(short y = 0; y < console->Height(); ++y) {
+            for(short x = 0; x < console->Width(); ++x) {
+                _background[y * console->Width() + x] = console->GetChar(x, y);
+            }
+        }
 
-            for(auto & entity : _entities) {
-                if(entity->HasComponentOfType("LivelySplatterController"_id)) {
-                    auto controller = (components::LivelySplatterController*)(entity->GetComponent("LivelySplatterController"_id));
-                    controller->ExecuteCommandsUntil(_time);
+        _drawnAt.clear();
+        auto view = IRect(this->_subcon1->Width(), 0, GAME_WIDTH - this->_subcon1->Width(), GAME_HEIGHT);
+        _world.ForEachInSystem<components::Position, components::Cell>(
+            [&](EntityPtr const& entity, components::Position const& epos, components::Cell const& ecell) {
+                if(!view.contains(epos.GetPosition())) {
+                    return;
                 }
-            }
+                _drawnAt[entity->GetHandle()] = epos.GetPosition();
+                if(entity != this->_player) {
+                    console->SetChar(epos.GetPosition().X, epos.GetPosition().Y, ecell.GetCChar());
+                }
+            },
+            system_id
+        );
+        _drawnSystem = system_id;
+        _redrawAll = false;
+    }
 
-            Render(); // This was moved here so that when I make commands take more than one tick, each tick can be drawn
+    void Game::drawChanges(sysid system_id) {
+        auto view = IRect(this->_subcon1->Width(), 0, GAME_WIDTH - this->_subcon1->Width(), GAME_HEIGHT);
+        auto registry = EntityRegistry::Get();
+        vec<IVector2> cells;
+        for(auto const& change : _changes.GetChanges()) {
+            auto drawn = _drawnAt.find(change.Entity);
+            if(drawn != std::end(_drawnAt)) {
+                cells.push_back(drawn->second);
+                _drawnAt.erase(drawn);
+            }
+            auto entity = registry->IsAlive(change.Entity) ? registry->Resolve(change.Entity) : nullptr;
+            auto epos = (entity != nullptr) ? entity->TryGet<components::Position>() : nullptr;
+            if((epos != nullptr) && (epos->GetCurrentSystem() == system_id) && view.contains(epos->GetPosition())) {
+                cells.push_back(epos->GetPosition());
+            }
+        }
+        for(auto const& cell : cells) {
+            drawCell(cell, system_id);
+        }
+    }
 
-            if(_actionPerformed) {
-                ++_time;
+    void Game::drawCell(IVector2 const& cell, sysid system_id) {
+        auto console = Console::Get();
+        console->SetChar(cell.X, cell.Y, _background[cell.Y * console->Width() + cell.X]);
+        vec<ptr<IEntity>> occupants;
+        _world.QueryEntitiesAt(cell, occupants, system_id);
+        for(auto occupant : occupants) {
+            auto ecell = occupant->TryGet<components::Cell>();
+            if(ecell == nullptr) {
+                continue;
             }
-        } while(!p_controller->CanAct());
+            _drawnAt[occupant->GetHandle()] = cell;
+            if(occupant != this->_player.get()) {
+                console->SetChar(cell.X, cell.Y, ecell->GetCChar());
+            }
+        }
+    }
+
+    void Game::Update() {
+        auto p_controller = _player->Get<components::PlayerController>();
+        _actionPerformed = false;
+        HandleEvents();
+        if(_recorder != nullptr) {
+            _recorder->EndFrame(_time, _actionPerformed, !p_controller->CanAct());
+        }
+        simulate(p_controller);
+        EntityRegistry::Get()->Collect();
     }
     void Game::HandleEvents() {
         auto console = Console::Get();
@@ -215,10 +300,26 @@ namespace gquest {
         return this->_subcon1.get();
     }
 
+    RenderScheduler & Game::GetRenderScheduler() {
+        return _frames;
+    }
+
+    IRect const & Game::GetPlayArea() const {
+        return _playArea;
+    }
+
     uint_ Game::Now() const {
         return _time;
     }
 
+    void Game::SetSkipIdleTicks(bool enabled) {
+        _skipIdleTicks = enabled;
+    }
+
+    bool Game::IsSkippingIdleTicks() const {
+        return _skipIdleTicks;
+    }
+
     bool Game::WasActionPerformedThisFrame() const {
         return _actionPerformed;
     }
@@ -227,27 +328,268 @@ namespace gquest {
         _actionPerformed = true;
     }
 
+    void Game::Seed(ui32 seed) {
+        _seed = seed;
+        _rng.engine().seed(seed);
+        _inputRng.engine().seed(seed ^ 0x9E3779B9u);
+    }
+
+    ui32 Game::GetSeed() const {
+        return _seed;
+    }
+
     mt19937_rng & Game::GetRandom() {
         return _rng;
     }
 
-    void Game::AddEntity(EntityPtr entity) {
-        auto iter = std::find(std::begin(_entities), std::end(_entities), entity);
-        if(iter == std::end(_entities)) {
-            _entities.push_back(entity);
-            return;
+    mt19937_rng & Game::GetInputRandom() {
+        return _inputRng;
+    }
+
+    void Game::StartRecording(string const& path, uint_ checksum_interval) {
+        _recordPath = path;
+        _checksumInterval = checksum_interval;
+    }
+
+    void Game::RecordCommand(Command const& command) {
+        if(_recorder != nullptr) {
+            _recorder->Record(command);
         }
     }
 
+    void Game::StartHeadless(IRect const& play_area) {
+        _headless = true;
+        setUp(play_area);
+        startRecorder();
+    }
+
+    void Game::PlayFrame(InputFrame const& frame) {
+        auto p_controller = _player->Get<components::PlayerController>();
+        for(auto const& command : frame.Commands) {
+            p_controller->PushCommand(command);
+        }
+        if(frame.PlayerActed) {
+            p_controller->Acted();
+        }
+        _actionPerformed = frame.Acted;
+        if(_recorder != nullptr) {
+            for(auto const& command : frame.Commands) {
+                _recorder->Record(command);
+            }
+            _recorder->EndFrame(_time, frame.Acted, frame.PlayerActed);
+        }
+        simulate(p_controller);
+        EntityRegistry::Get()->Collect();
+    }
+
+    ReplayResult Game::Replay(InputLog const& log) {
+        ReplayResult result = { };
+        Seed(log.Seed);
+        _checksumInterval = log.ChecksumInterval;
+        StartHeadless(log.PlayArea);
+
+        auto expected = std::begin(log.Checksums);
+        _onChecksum = [&](uint_ tick, ui64 value) {
+            if(result.Diverged || (expected == std::end(log.Checksums))) {
+                return;
+            }
+            if((expected->Tick != tick) || (expected->Value != value)) {
+                result.Diverged = true;
+                result.DivergedAt = tick;
+                return;
+            }
+            ++expected;
+            ++result.ChecksumsMatched;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for(auto const& frame : log.Frames) {
+            if(result.Diverged) {
+                break;
+            }
+            if(frame.Tick != _time) {
+                result.Diverged = true;
+                result.DivergedAt = _time;
+                break;
+            }
+            PlayFrame(frame);
+            ++result.Frames;
+        }
+        // A replay that never reaches a checksum the log has was cut short or lost ticks
+        if(!result.Diverged && (expected != std::end(log.Checksums))) {
+            result.Diverged = true;
+            result.DivergedAt = expected->Tick;
+        }
+        result.Seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        result.Ticks = _time;
+        _onChecksum = nullptr;
+        return result;
+    }
+
+    ui64 Game::Checksum() {
+        ui64 entities = 0;
+        ui64 sum = 0;
+        _world.ForEach<components::Position>([&](EntityPtr const&, components::Position const& pos) {
+            // Summed so that the order entities are visited in doesn't matter. Handles
+            // are left out, since they depend on what the EntityRegistry handed out
+            // before the session started rather than on the session itself.
+            auto hash = fnv1a(0xCBF29CE484222325ull, pos.GetCurrentSystem());
+            hash = fnv1a(hash, static_cast<ui64>(pos.GetPosition().X));
+            hash = fnv1a(hash, static_cast<ui64>(pos.GetPosition().Y));
+            sum += hash;
+            ++entities;
+        });
+        auto hash = fnv1a(0xCBF29CE484222325ull, _time);
+        hash = fnv1a(hash, entities);
+        return fnv1a(hash, sum);
+    }
+
+    ptr<World> Game::GetWorld() {
+        return &_world;
+    }
+
+    EntityChangeList const & Game::GetChanges() const {
+        return _changes.GetChanges();
+    }
+
+    EntityHandle Game::AddEntity(EntityPtr entity) {
+        auto handle = EntityRegistry::Get()->Register(entity);
+        if(_entities.insert(handle).second) {
+            _redrawAll = true;
+            sysid system_id = World::NoSystem;
+            auto pos = entity->TryGet<components::Position>();
+            if(pos != nullptr) {
+                system_id = pos->GetCurrentSystem();
+            }
+            _world.AddEntityToSystem(handle, system_id);
+            // Commands pushed before the entity had a handle were never scheduled
+            auto controller = entity->TryGet<components::LivelySplatterController>();
+            if(controller != nullptr) {
+                controller->ScheduleWakeup();
+            }
+        }
+        return handle;
+    }
+
     void Game::RemoveEntity(EntityPtr entity) {
-        auto iter = std::find(std::begin(_entities), std::end(_entities), entity);
-        if(iter != std::end(_entities)) {
-            _entities.erase(iter);
+        if(entity != nullptr) {
+            RemoveEntity(entity->GetHandle());
+        }
+    }
+
+    void Game::RemoveEntity(EntityHandle entity) {
+        if(_entities.erase(entity) > 0) {
+            _redrawAll = true;
+            _world.RemoveEntity(entity);
+            EntityRegistry::Get()->Release(entity);
         }
     }
 
     void Game::RemoveAllEntities() {
+        auto registry = EntityRegistry::Get();
+        for(auto entity : _entities) {
+            _world.RemoveEntity(entity);
+            registry->Release(entity);
+        }
         _entities.clear();
+        _redrawAll = true;
+    }
+
+    void Game::catchUpSystem(sysid system_id, uint_ from, uint_ to) {
+        // Commands read the time from Now(), so the clock is wound back while
+        // the system is stepped forward and restored afterwards. Each step
+        // runs everything due by its time, including commands that earlier
+        // ones queue for within it, and the last step stops just short of
+        // to, which the system's own run covers.
+        auto now = _time;
+        for(uint_ t = from; t + 1 < to;) {
+            t = std::min(t + CATCH_UP_STEP, to - 1);
+            _time = t;
+            _world.ForEachInSystem<components::LivelySplatterController>(
+                [this](EntityPtr const&, components::LivelySplatterController & controller) { controller.ExecuteCommandsUntil(_time); },
+                system_id
+            );
+        }
+        _time = now;
+        // Wakeups that came due while the system was dormant were dropped
+        _world.ForEachInSystem<components::LivelySplatterController>(
+            [](EntityPtr const&, components::LivelySplatterController & controller) { controller.ScheduleWakeup(); },
+            system_id
+        );
+    }
+
+    void Game::startRecorder() {
+        if(_recordPath.empty()) {
+            return;
+        }
+        _recorder = uptr<InputRecorder>(new InputRecorder(_recordPath, _seed, _playArea, _checksumInterval));
+        _onChecksum = [this](uint_ tick, ui64 value) { this->_recorder->RecordChecksum(tick, value); };
+    }
+
+    void Game::setUp(IRect const& play_area) {
+        this->_playArea = play_area;
+        this->_time = 0;
+        this->_actionPerformed = false;
+        this->_nextChecksum = 0;
+        // The wheel is shared, and may still be at the time a previous Game ended on
+        CommandScheduler::Get()->Reset(0);
+        this->_redrawAll = true;
+
+        // Registering again for a later Game just replaces everything with the same
+        PlayerEntity::RegisterPrefab(*PrefabRegistry::Get());
+        LivelySplatterEntity::RegisterPrefab(*PrefabRegistry::Get());
+        components::PlayerController::RegisterCommandHandlers(*CommandHandlerRegistry::Get());
+        components::LivelySplatterController::RegisterCommandHandlers(*CommandHandlerRegistry::Get());
+
+        this->_player = sptr<PlayerEntity>(new PlayerEntity(GAME_WIDTH / 2, GAME_HEIGHT / 2));
+        this->_entities = { };
+        this->_world.SetCatchUpCallback([this](sysid system_id, uint_ from, uint_ to) { this->catchUpSystem(system_id, from, to); });
+        this->_world.SetDormancyEnabled(true);
+        this->SetSkipIdleTicks(true);
+        this->_systems.AddSystem(SimulationSystemUPtr(new simulation::LivelySplatterSystem()));
+        this->_world.AddEntityToSystem(this->_player, this->_player->Get<components::Position>()->GetCurrentSystem());
+        this->_world.SetObserver(this->_player);
+    }
+
+    void Game::simulate(ptr<components::PlayerController> p_controller) {
+        if(_headless) {
+            _changes.Clear();
+        }
+        do {
+            p_controller->ExecuteCommandsUntil(_time);
+
+            _systems.Run(_world, _time);
+            ChangeTracker::Get()->Drain(_tickChanges);
+            _changes.Add(_tickChanges);
+
+            if(_onChecksum && (_time >= _nextChecksum)) {
+                _onChecksum(_time, Checksum());
+                _nextChecksum = (_checksumInterval == 0) ? std::numeric_limits<uint_>::max() : (_time / _checksumInterval + 1) * _checksumInterval;
+            }
+
+            // This was moved here so that when I make commands take more than one tick, each tick can be drawn
+            if(!_skipIdleTicks || !_tickChanges.empty()) {
+                _frames.MarkDirty();
+            }
+            // A headless game still asks, so the frames it would have drawn are counted
+            if(_frames.ShouldRender(p_controller->CanAct()) && !_headless) {
+                Render();
+            }
+
+            if(_actionPerformed) {
+                _time = nextTick(p_controller);
+            }
+        } while(!p_controller->CanAct());
+    }
+
+    uint_ Game::nextTick(ptr<components::PlayerController> p_controller) const {
+        // Once the player can act again time has to go one tick at a time,
+        // or their next command would land past whatever is due in between
+        if(!_skipIdleTicks || p_controller->CanAct() || !p_controller->CommandsAvailable()) {
+            return _time + 1;
+        }
+        auto next = std::min(p_controller->GetTopCommand().GetWhen(), CommandScheduler::Get()->NextWakeup());
+        return std::max(next, _time + 1);
     }
 
     ptr<Game> Game::Get() {
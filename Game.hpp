@@ -29,6 +29,11 @@
 #include "EventHandler.hpp"
 #include "PlayerEntity.hpp"
 #include "LivelySplatterEntity.hpp"
+#include "World.hpp"
+#include "SimulationScheduler.hpp"
+#include "RenderScheduler.hpp"
+#include "ChangeTracker.hpp"
+#include "Replay.hpp"
 
 namespace gquest {
 
@@ -38,18 +43,62 @@ namespace gquest {
     constexpr int GAME_WIDTH = 120;
     constexpr int GAME_HEIGHT = 36;
 
+    /// <summary>
+    /// How many ticks a dormant system is advanced by at a time while it is being caught up
+    /// </summary>
+    constexpr uint_ CATCH_UP_STEP = 10;
+
     class Game {
     private:
         uptr<SubConsole> _subcon1;
-        uptr<PlayerEntity> _player;
-        vec<EntityPtr> _entities;
+        sptr<PlayerEntity> _player;
+        hashset<EntityHandle> _entities;
+        World _world;
+        SimulationScheduler _systems;
+        RenderScheduler _frames;
+        EntityChangeList _tickChanges;
+
+        /// <summary>
+        /// Holds the changes since the last frame was drawn, or since the start of the frame when headless
+        /// </summary>
+        EntityChangeSet _changes;
+
+        /// <summary>
+        /// Holds where each entity on the map was last drawn, so Render() only has to redraw the cells that changed
+        /// </summary>
+        hashmap<EntityHandle, IVector2> _drawnAt;
+        vec<CChar> _background;
+        sysid _drawnSystem;
+        bool _redrawAll;
         //int _playerX;
         //int _playerY;
         bool _running;
         bool _oldCursorVisible;
         bool _actionPerformed;
+
+        /// <summary>
+        /// Whether time jumps straight to the next due command while the player is waiting
+        /// </summary>
+        bool _skipIdleTicks;
         uint_ _time;
+        ui32 _seed;
         mt19937_rng _rng;
+        mt19937_rng _inputRng;
+
+        /// <summary>
+        /// Whether the game is being replayed without a console, in which case nothing is rendered
+        /// </summary>
+        bool _headless;
+        string _recordPath;
+        uptr<InputRecorder> _recorder;
+        uint_ _checksumInterval;
+        uint_ _nextChecksum;
+        function<void(uint_, ui64)> _onChecksum;
+
+        /// <summary>
+        /// The cells of the map that entities may move into, worked out once the consoles are set up
+        /// </summary>
+        IRect _playArea;
 
         vec<KeyEventHandlerPtr> _keyEventHandlers;
         vec<MouseEventHandlerPtr> _mouseEventHandlers;
@@ -83,17 +132,151 @@ namespace gquest {
 
         ptr<SubConsole> GetSubConsole1();
 
+        /// <summary>
+        /// Returns the scheduler that decides which of the simulated ticks are drawn
+        /// </summary>
+        RenderScheduler & GetRenderScheduler();
+
+        /// <summary>
+        /// Returns the cells of the map that entities may move into, inside of the border and right of the side panel
+        /// </summary>
+        IRect const& GetPlayArea() const;
+
         uint_ Now() const;
+
+        /// <summary>
+        /// Turns jumping over ticks on which no command is due on or off
+        /// </summary>
+        /// <remarks>
+        /// While the player is waiting on a command that is not due yet,
+        /// Update() moves the time straight to the earliest command due for
+        /// the player or any scheduled controller, instead of ticking one at
+        /// a time, and only ticks on which something changed are offered to
+        /// the RenderScheduler. Simulation systems are only run on the
+        /// ticks that are visited.
+        /// </remarks>
+        void SetSkipIdleTicks(bool enabled);
+        bool IsSkippingIdleTicks() const;
         bool WasActionPerformedThisFrame() const;
         void Acted();
 
+        /// <summary>
+        /// Seeds the simulation's random number generator and the one used while handling input
+        /// </summary>
+        void Seed(ui32 seed);
+        ui32 GetSeed() const;
+
         mt19937_rng & GetRandom();
 
-        void AddEntity(EntityPtr entity);
+        /// <summary>
+        /// Returns the random number generator for choices made while handling the player's input
+        /// </summary>
+        /// <remarks>
+        /// What those choices lead to is recorded as commands, so a replay
+        /// never draws from this generator, and keeping it apart from
+        /// GetRandom() keeps the simulation's draws the same either way.
+        /// </remarks>
+        mt19937_rng & GetInputRandom();
+
+        /// <summary>
+        /// Makes the next Run() or StartHeadless() write its seed, every command the player queues, and periodic checksums to an InputLog at path
+        /// </summary>
+        /// <remarks>
+        /// A headless game records the frames given to PlayFrame().
+        /// </remarks>
+        void StartRecording(string const& path, uint_ checksum_interval = DEFAULT_CHECKSUM_INTERVAL);
+
+        /// <summary>
+        /// Adds a command the player queued to the frame being recorded, iff recording
+        /// </summary>
+        void RecordCommand(Command const& command);
+
+        /// <summary>
+        /// Sets the game up without a console, to be driven by PlayFrame() instead of Run()
+        /// </summary>
+        void StartHeadless(IRect const& play_area);
+
+        /// <summary>
+        /// Queues a frame's commands for the player and simulates ticks until the player can act again, as Update() would have
+        /// </summary>
+        void PlayFrame(InputFrame const& frame);
+
+        /// <summary>
+        /// Plays a recorded session back without a console, as fast as it will go, checking the world against the log's checksums
+        /// </summary>
+        /// <remarks>
+        /// Call this on a fresh Game instead of Run(). The replay stops at
+        /// the first frame or checksum that does not match the log.
+        /// </remarks>
+        ReplayResult Replay(InputLog const& log);
+
+        /// <summary>
+        /// Returns a hash of the time and of every entity's system and position, independent of the order entities are stored in
+        /// </summary>
+        ui64 Checksum();
+
+        ptr<World> GetWorld();
+
+        /// <summary>
+        /// Returns the entities whose components changed since the last frame was drawn, or during the last frame when headless
+        /// </summary>
+        EntityChangeList const& GetChanges() const;
+
+        /// <summary>
+        /// Registers an entity, adds it to the World, and returns its handle
+        /// </summary>
+        EntityHandle AddEntity(EntityPtr entity);
+
+        /// <summary>
+        /// Removes an entity from the World and releases its handle
+        /// </summary>
+        /// <remarks>
+        /// The entity itself is destroyed at the end of the current Update(),
+        /// once nothing can still be running on it.
+        /// </remarks>
         void RemoveEntity(EntityPtr entity);
+        void RemoveEntity(EntityHandle entity);
         void RemoveAllEntities();
 
         static ptr<Game> Get();
+
+    private:
+        /// <summary>
+        /// Creates the player and sets up the World and simulation systems, shared by Run() and Replay()
+        /// </summary>
+        void setUp(IRect const& play_area);
+
+        /// <summary>
+        /// Starts writing the InputLog asked for by StartRecording(), iff it was
+        /// </summary>
+        void startRecorder();
+
+        /// <summary>
+        /// Simulates ticks until the player can act again, rendering them unless headless
+        /// </summary>
+        void simulate(ptr<components::PlayerController> p_controller);
+
+        void catchUpSystem(sysid system_id, uint_ from, uint_ to);
+
+        /// <summary>
+        /// Draws the background and every entity of a system that is in view
+        /// </summary>
+        void drawMap(sysid system_id);
+
+        /// <summary>
+        /// Redraws only the cells that the changed entities were last drawn in or have moved into
+        /// </summary>
+        void drawChanges(sysid system_id);
+
+        /// <summary>
+        /// Puts the background back in a cell and draws whatever of the system is in it now, other than the player
+        /// </summary>
+        void drawCell(IVector2 const& cell, sysid system_id);
+
+        /// <summary>
+        /// Returns the tick Update() moves on to once the current one has been simulated
+        /// </summary>
+        uint_ nextTick(ptr<components::PlayerController> p_controller) const;
     };
 
 }
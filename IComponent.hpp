@@ -30,13 +30,88 @@ namespace gquest {
     class IComponent {
     protected:
         IEntity * _parent;
+        ui64 _version;
     public:
-        IComponent(IEntity * parent=nullptr) : _parent(parent) { }
+        IComponent(IEntity * parent=nullptr) : _parent(parent), _version(0) { }
+        virtual ~IComponent() { }
         inline IEntity * GetParent() { return _parent; }
         inline void SetParent(IEntity * parent) { _parent = parent; }
         virtual idtype GetId() const = 0;
+
+        /// <summary>
+        /// Returns the version stamp of the last change to the component, or 0 iff it has never changed
+        /// </summary>
+        inline ui64 GetVersion() const { return _version; }
+
+    protected:
+        /// <summary>
+        /// Stamps the component with a new version and reports its entity to the ChangeTracker
+        /// </summary>
+        void markChanged(uint_ slot);
+    };
+
+    /// <summary>
+    /// The number of component types that get a slot in the per-entity component caches
+    /// </summary>
+    constexpr uint_ MaxComponentSlots = 16;
+
+    /// <summary>
+    /// Slot given to component types once every slot is taken
+    /// </summary>
+    constexpr uint_ NoComponentSlot = MaxComponentSlots;
+
+    /// <summary>
+    /// Hands out small dense indices to component ids, in the order they are first asked for
+    /// </summary>
+    class ComponentSlots {
+    public:
+        /// <summary>
+        /// Returns the slot of a component id, or NoComponentSlot iff they have all been handed out
+        /// </summary>
+        static uint_ Of(idtype component_id);
     };
 
+    /// <summary>
+    /// Returns the slot of a component type that has a static TypeId
+    /// </summary>
+    template <class ComponentType>
+    inline uint_ ComponentSlot() {
+        static const uint_ slot = ComponentSlots::Of(ComponentType::TypeId);
+        return slot;
+    }
+
+    /// <summary>
+    /// A set of component types, one bit per slot
+    /// </summary>
+    using ComponentMask = std::bitset<MaxComponentSlots>;
+
+    /// <summary>
+    /// Returns the mask with the bit of a component id set
+    /// </summary>
+    /// <remarks>
+    /// Throws std::runtime_error iff the component has no slot, since a
+    /// mask without its bit would silently match every entity.
+    /// </remarks>
+    inline ComponentMask MaskOfId(idtype component_id) {
+        auto slot = ComponentSlots::Of(component_id);
+        if(slot >= MaxComponentSlots) {
+            throw std::runtime_error("Component type has no slot to put in a mask");
+        }
+        return ComponentMask().set(slot);
+    }
+
+    /// <summary>
+    /// Returns the mask of a list of component types that have a static TypeId
+    /// </summary>
+    template <class ...ComponentTypes>
+    inline ComponentMask MaskOf() {
+        ComponentMask mask;
+        for(auto component_id : vec<idtype>{ ComponentTypes::TypeId... }) {
+            mask |= MaskOfId(component_id);
+        }
+        return mask;
+    }
+
     using ComponentPtr = ptr<IComponent>;
     using ComponentUPtr = uptr<IComponent>;
     using ComponentSPtr = sptr<IComponent>;
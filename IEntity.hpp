@@ -23,6 +23,7 @@
 
 #include "GalactiQuestBase.hpp"
 #include "IComponent.hpp"
+#include "EntityHandle.hpp"
 
 #include <map>
 #include <memory>
@@ -30,14 +31,66 @@
 namespace gquest {
 
     class IEntity {
+    protected:
+        /// <summary>
+        /// The slots of every component the entity has, kept up to date by implementations
+        /// </summary>
+        ComponentMask _signature;
+
     public:
+        virtual ~IEntity() { }
+
+        inline ComponentMask const& GetSignature() const { return _signature; }
+
+        /// <summary>
+        /// Returns true iff the entity has every component in a mask
+        /// </summary>
+        inline bool HasComponents(ComponentMask const& required) const { return (_signature & required) == required; }
+
         virtual bool HasComponentOfType(idtype component_id) const = 0;
         virtual ComponentPtr GetComponent(idtype component_id) = 0;
         virtual void AddComponent(ComponentPtr component) = 0;
         virtual void RemoveComponent(idtype component_id) = 0;
         virtual void RemoveAllComponents() = 0;
+        virtual EntityHandle GetHandle() const = 0;
+        virtual void SetHandle(EntityHandle handle) = 0;
+
+        /// <summary>
+        /// Returns a component by its slot, falling back to its id iff it has no slot
+        /// </summary>
+        virtual ComponentPtr GetComponentInSlot(uint_ slot, idtype component_id) = 0;
+
+        /// <summary>
+        /// Returns the component of a type, which the entity must have
+        /// </summary>
+        /// <remarks>
+        /// ComponentType needs a static TypeId. Throws std::runtime_error iff
+        /// the entity does not have the component; use TryGet when it may not.
+        /// </remarks>
+        template <class ComponentType>
+        ComponentType * Get();
+
+        /// <summary>
+        /// Returns the component of a type, or nullptr iff the entity does not have one
+        /// </summary>
+        template <class ComponentType>
+        ComponentType * TryGet();
     };
 
+    template <class ComponentType>
+    inline ComponentType * IEntity::Get() {
+        auto component = TryGet<ComponentType>();
+        if(component == nullptr) {
+            throw std::runtime_error("Entity does not have the requested component");
+        }
+        return component;
+    }
+
+    template <class ComponentType>
+    inline ComponentType * IEntity::TryGet() {
+        return static_cast<ComponentType*>(GetComponentInSlot(ComponentSlot<ComponentType>(), ComponentType::TypeId));
+    }
+
     using EntityPtr = sptr<IEntity>;
     using EntityUPtr = uptr<IEntity>;
     using EntityList = vec<EntityPtr>;
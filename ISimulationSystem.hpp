@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "IComponent.hpp"
+
+namespace gquest {
+
+    class World;
+
+    /// <summary>
+    /// A piece of per-tick simulation logic that declares which components it touches
+    /// </summary>
+    /// <remarks>
+    /// Not to be confused with star systems. The SimulationScheduler uses
+    /// the read and write masks to decide which simulation systems may run
+    /// at the same time, so they have to cover everything Run touches.
+    /// </remarks>
+    class ISimulationSystem {
+    public:
+        virtual ~ISimulationSystem() { }
+
+        virtual idtype GetId() const = 0;
+
+        /// <summary>
+        /// Returns the components the system only reads
+        /// </summary>
+        virtual ComponentMask GetReads() const = 0;
+
+        /// <summary>
+        /// Returns the components the system changes
+        /// </summary>
+        virtual ComponentMask GetWrites() const = 0;
+
+        /// <summary>
+        /// Returns true iff the system uses shared state that components do not describe
+        /// </summary>
+        /// <remarks>
+        /// Exclusive systems run on their own, on the calling thread, after
+        /// every system added before them and before every system added
+        /// after them. Anything that spawns entities, uses Game::GetRandom(),
+        /// or calls World::RunOnActiveEntities has to be exclusive.
+        /// </remarks>
+        virtual bool IsExclusive() const { return false; }
+
+        virtual void Run(World & world, uint_ now) = 0;
+    };
+
+    using SimulationSystemUPtr = uptr<ISimulationSystem>;
+
+}
@@ -0,0 +1,162 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "JobPool.hpp"
+
+namespace gquest {
+
+    namespace {
+        thread_local bool t_insideJob = false;
+    }
+
+    uptr<JobPool> JobPool::_instance = nullptr;
+
+    JobPool::JobPool(uint_ workers) : _generation(0), _stopping(false), _remaining(0), _error(nullptr) {
+        if(workers == 0) {
+            uint_ hardware = std::thread::hardware_concurrency();
+            workers = (hardware > 1) ? hardware - 1 : 0;
+        }
+        for(uint_ i = 0; i <= workers; ++i) {
+            _queues.push_back(uptr<JobQueue>(new JobQueue()));
+        }
+        for(uint_ i = 1; i <= workers; ++i) {
+            _workers.push_back(std::thread([this, i]() { workerLoop(i); }));
+        }
+    }
+
+    JobPool::~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            _stopping = true;
+        }
+        _wakeCondition.notify_all();
+        for(auto & worker : _workers) {
+            worker.join();
+        }
+    }
+
+    uint_ JobPool::Concurrency() const {
+        return _queues.size();
+    }
+
+    void JobPool::Run(vec<Job> const& jobs) {
+        if(jobs.empty()) {
+            return;
+        }
+        if(t_insideJob || _workers.empty() || (jobs.size() == 1)) {
+            for(auto const& job : jobs) {
+                job();
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> runLock(_runMutex);
+        _error = nullptr;
+        _remaining = jobs.size();
+        for(uint_ i = 0; i < jobs.size(); ++i) {
+            auto & queue = *_queues[i % _queues.size()];
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            queue.Jobs.push_back(&jobs[i]);
+        }
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            ++_generation;
+        }
+        _wakeCondition.notify_all();
+
+        t_insideJob = true;
+        work(0);
+        t_insideJob = false;
+
+        {
+            std::unique_lock<std::mutex> lock(_doneMutex);
+            _doneCondition.wait(lock, [this]() { return _remaining == 0; });
+        }
+        if(_error != nullptr) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+    ptr<JobPool> JobPool::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<JobPool>(new JobPool());
+        }
+        return _instance.get();
+    }
+
+    void JobPool::workerLoop(uint_ queue_index) {
+        t_insideJob = true;
+        uint_ seen = 0;
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(_wakeMutex);
+                _wakeCondition.wait(lock, [&]() { return _stopping || (_generation != seen); });
+                if(_stopping) {
+                    return;
+                }
+                seen = _generation;
+            }
+            work(queue_index);
+        }
+    }
+
+    void JobPool::work(uint_ queue_index) {
+        ptr<Job const> job;
+        while(takeJob(queue_index, job)) {
+            try {
+                (*job)();
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(_doneMutex);
+                if(_error == nullptr) {
+                    _error = std::current_exception();
+                }
+            }
+            if(--_remaining == 0) {
+                std::lock_guard<std::mutex> lock(_doneMutex);
+                _doneCondition.notify_all();
+            }
+        }
+    }
+
+    bool JobPool::takeJob(uint_ queue_index, ptr<Job const> & job) {
+        {
+            auto & own = *_queues[queue_index];
+            std::lock_guard<std::mutex> lock(own.Mutex);
+            if(!own.Jobs.empty()) {
+                job = own.Jobs.front();
+                own.Jobs.pop_front();
+                return true;
+            }
+        }
+        for(uint_ i = 1; i < _queues.size(); ++i) {
+            auto & victim = *_queues[(queue_index + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+            if(!victim.Jobs.empty()) {
+                job = victim.Jobs.back();
+                victim.Jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
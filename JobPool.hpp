@@ -0,0 +1,97 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A fixed set of worker threads that run batches of jobs
+    /// </summary>
+    /// <remarks>
+    /// Each batch is dealt out round-robin to one queue per worker, plus one
+    /// for the calling thread. A participant works from the front of its own
+    /// queue and steals from the back of the others once it runs dry, so
+    /// batches made of jobs with very different costs still keep every
+    /// thread busy.
+    ///
+    /// Only one batch runs at a time. A job that starts another batch has
+    /// that batch run serially on its own thread.
+    /// </remarks>
+    class JobPool {
+    public:
+        using Job = function<void()>;
+
+    private:
+        struct JobQueue {
+            std::mutex Mutex;
+            std::deque<ptr<Job const>> Jobs;
+        };
+
+        vec<std::thread> _workers;
+        vec<uptr<JobQueue>> _queues;
+
+        std::mutex _runMutex;
+        std::mutex _wakeMutex;
+        std::condition_variable _wakeCondition;
+        std::mutex _doneMutex;
+        std::condition_variable _doneCondition;
+        uint_ _generation;
+        bool _stopping;
+        std::atomic<uint_> _remaining;
+        std::exception_ptr _error;
+
+        static uptr<JobPool> _instance;
+    public:
+        /// <summary>
+        /// Creates a pool with the given number of workers
+        /// </summary>
+        /// <param name="workers">The number of threads to create besides the calling thread, or 0 to use one less than the number of hardware threads</param>
+        JobPool(uint_ workers = 0);
+        JobPool(JobPool const&) = delete;
+        JobPool & operator =(JobPool const&) = delete;
+        ~JobPool();
+
+        /// <summary>
+        /// Returns the number of threads that take part in a batch, including the calling thread
+        /// </summary>
+        uint_ Concurrency() const;
+
+        /// <summary>
+        /// Runs every job and returns once they have all finished
+        /// </summary>
+        /// <remarks>
+        /// If any job throws, the first exception is rethrown here after the
+        /// rest of the batch has finished.
+        /// </remarks>
+        void Run(vec<Job> const& jobs);
+
+        static ptr<JobPool> Get();
+
+    private:
+        void workerLoop(uint_ queue_index);
+        void work(uint_ queue_index);
+        bool takeJob(uint_ queue_index, ptr<Job const> & job);
+    };
+
+}
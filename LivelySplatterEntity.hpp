@@ -1,43 +1,68 @@
 #pragma once
-#include "BaseEntity.hpp"
+#include "ArchetypeEntity.hpp"
 #include "Components.hpp"
+#include "Pool.hpp"
+#include "Prefab.hpp"
 
 namespace gquest {
 
     class LivelySplatterEntity :
-        public BaseEntity {
+        public ArchetypeEntity,
+        public Pooled<LivelySplatterEntity> {
     public:
+        static constexpr idtype PrefabId = "LivelySplatter"_id;
 
         LivelySplatterEntity() {
-            this->AddComponents(
-                new components::Name(L"Lively Splatter"),
-                new components::Position(0, IVector2(0, 0), false),
-                new components::Cell((wchar_t)u'\x2248', Attr::FgLightRed | Attr::BgRed),
-                new components::LivelySplatterController()
-            );
+            GetPrefab().Instantiate(this);
         }
 
         LivelySplatterEntity(IVector2 const& pos) {
-            this->AddComponents(
-                new components::Name(L"Lively Splatter"),
-                new components::Position(0, pos, false),
-                new components::Cell((wchar_t)u'\x2248', Attr::FgLightRed | Attr::BgRed),
-                new components::LivelySplatterController()
-            );
+            GetPrefab().Instantiate(this, pos);
         }
 
         LivelySplatterEntity(int_ x, int_ y) {
-            this->AddComponents(
-                new components::Name(L"Lively Splatter"),
-                new components::Position(0, IVector2(x, y), false),
-                new components::Cell((wchar_t)u'\x2248', Attr::FgLightRed | Attr::BgRed),
-                new components::LivelySplatterController()
-            );
+            GetPrefab().Instantiate(this, IVector2(x, y));
+        }
+
+        /// <summary>
+        /// Creates one entity at each position, copying all of their components in together
+        /// </summary>
+        static vec<sptr<LivelySplatterEntity>> Spawn(vec<IVector2> const& positions) {
+            vec<sptr<LivelySplatterEntity>> spawned;
+            vec<ptr<ArchetypeEntity>> entities;
+            spawned.reserve(positions.size());
+            entities.reserve(positions.size());
+            for(uint_ i = 0; i < positions.size(); ++i) {
+                spawned.push_back(sptr<LivelySplatterEntity>(new LivelySplatterEntity(Unformed())));
+                entities.push_back(spawned.back().get());
+            }
+            GetPrefab().Instantiate(entities, positions);
+            return spawned;
+        }
+
+        /// <summary>
+        /// Adds the prefab every LivelySplatterEntity is made from to a registry
+        /// </summary>
+        static void RegisterPrefab(PrefabRegistry & registry) {
+            registry.Register(PrefabId)->
+                Copy(components::Name(L"Lively Splatter")).
+                Copy(components::Position(0, IVector2(0, 0), false)).
+                Copy(components::Cell((wchar_t)u'\x2248', Attr::FgLightRed | Attr::BgRed)).
+                Construct<components::LivelySplatterController>();
+        }
+
+        static Prefab const& GetPrefab() {
+            return PrefabRegistry::Get()->Find(PrefabId);
         }
 
         ~LivelySplatterEntity() {
             this->RemoveAllComponents();
         }
+
+    private:
+        struct Unformed { };
+
+        LivelySplatterEntity(Unformed) { }
     };
 
 }
@@ -1,38 +1,42 @@
 #pragma once
-#include "BaseEntity.hpp"
+#include "ArchetypeEntity.hpp"
 #include "Components.hpp"
+#include "Pool.hpp"
+#include "Prefab.hpp"
 
 namespace gquest {
 
     class PlayerEntity :
-        public BaseEntity {
+        public ArchetypeEntity,
+        public Pooled<PlayerEntity> {
     public:
+        static constexpr idtype PrefabId = "Player"_id;
 
         PlayerEntity() {
-            this->AddComponents(
-                new components::Name(L"Player"),
-                new components::Position(0, IVector2(0, 0), false),
-                new components::Cell(L'@', Attr::FgLightGreen),
-                new components::PlayerController()
-            );
+            GetPrefab().Instantiate(this);
         }
 
         PlayerEntity(IVector2 const& pos) {
-            this->AddComponents(
-                new components::Name(L"Player"),
-                new components::Position(0, pos, false),
-                new components::Cell(L'@', Attr::FgLightGreen),
-                new components::PlayerController()
-            );
+            GetPrefab().Instantiate(this, pos);
         }
 
         PlayerEntity(int_ x, int_ y) {
-            this->AddComponents(
-                new components::Name(L"Player"),
-                new components::Position(0, IVector2(x, y), false),
-                new components::Cell(L'@', Attr::FgLightGreen),
-                new components::PlayerController()
-            );
+            GetPrefab().Instantiate(this, IVector2(x, y));
+        }
+
+        /// <summary>
+        /// Adds the prefab every PlayerEntity is made from to a registry
+        /// </summary>
+        static void RegisterPrefab(PrefabRegistry & registry) {
+            registry.Register(PrefabId)->
+                Copy(components::Name(L"Player")).
+                Copy(components::Position(0, IVector2(0, 0), false)).
+                Copy(components::Cell(L'@', Attr::FgLightGreen)).
+                Construct<components::PlayerController>();
+        }
+
+        static Prefab const& GetPrefab() {
+            return PrefabRegistry::Get()->Find(PrefabId);
         }
 
         ~PlayerEntity() {
@@ -0,0 +1,54 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Pool.hpp"
+
+namespace gquest {
+
+    namespace {
+        std::mutex & sourcesMutex() {
+            static auto mutex = new std::mutex();
+            return *mutex;
+        }
+
+        vec<PoolRegistry::StatisticsSource> & sources() {
+            static auto list = new vec<PoolRegistry::StatisticsSource>();
+            return *list;
+        }
+    }
+
+    void PoolRegistry::Register(StatisticsSource const & source) {
+        std::lock_guard<std::mutex> lock(sourcesMutex());
+        sources().push_back(source);
+    }
+
+    vec<PoolStatistics> PoolRegistry::GetStatistics() {
+        std::lock_guard<std::mutex> lock(sourcesMutex());
+        vec<PoolStatistics> statistics;
+        statistics.reserve(sources().size());
+        for(auto const& source : sources()) {
+            statistics.push_back(source());
+        }
+        return statistics;
+    }
+
+}
@@ -0,0 +1,168 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A snapshot of how much an ObjectPool has been used
+    /// </summary>
+    struct PoolStatistics {
+        std::string TypeName;
+        uint_ BlockSize;
+        ui64 Allocations;
+        ui64 Deallocations;
+        ui64 Slabs;
+        ui64 Live;
+    };
+
+    /// <summary>
+    /// Keeps track of every ObjectPool so their statistics can be reported together
+    /// </summary>
+    class PoolRegistry {
+    public:
+        using StatisticsSource = function<PoolStatistics()>;
+
+        static void Register(StatisticsSource const& source);
+
+        /// <summary>
+        /// Returns the statistics of every pool that has been used
+        /// </summary>
+        static vec<PoolStatistics> GetStatistics();
+    };
+
+    /// <summary>
+    /// Hands out fixed size blocks for objects of a single type, carved out of larger slabs
+    /// </summary>
+    /// <remarks>
+    /// Freed blocks go on a free list and are reused before a new slab is
+    /// allocated. Slabs are never handed back, and each pool is deliberately
+    /// never destroyed so that objects freed during static destruction
+    /// still have somewhere to go.
+    /// </remarks>
+    template <class Type>
+    class ObjectPool {
+    public:
+        static constexpr uint_ BlocksPerSlab = 64;
+
+    private:
+        union Block {
+            Block * Next;
+            typename std::aligned_storage<sizeof(Type), alignof(Type)>::type Storage;
+        };
+
+        std::mutex _mutex;
+        Block * _free;
+        vec<Block*> _slabs;
+        ui64 _allocations;
+        ui64 _deallocations;
+
+        ObjectPool() : _free(nullptr), _allocations(0), _deallocations(0) { }
+
+    public:
+        ObjectPool(ObjectPool const&) = delete;
+        ObjectPool & operator =(ObjectPool const&) = delete;
+
+        inline void * Allocate() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(_free == nullptr) {
+                grow();
+            }
+            auto block = _free;
+            _free = block->Next;
+            ++_allocations;
+            return block;
+        }
+
+        inline void Deallocate(void * memory) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto block = static_cast<Block*>(memory);
+            block->Next = _free;
+            _free = block;
+            ++_deallocations;
+        }
+
+        PoolStatistics GetStatistics() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return PoolStatistics{
+                typeid(Type).name(), sizeof(Block),
+                _allocations, _deallocations, _slabs.size(), _allocations - _deallocations
+            };
+        }
+
+        static ObjectPool & Get() {
+            static ptr<ObjectPool> pool = create();
+            return *pool;
+        }
+
+    private:
+        void grow() {
+            auto slab = static_cast<Block*>(::operator new(sizeof(Block) * BlocksPerSlab));
+            for(uint_ i = 0; i < BlocksPerSlab; ++i) {
+                slab[i].Next = (i + 1 < BlocksPerSlab) ? &slab[i + 1] : _free;
+            }
+            _free = slab;
+            _slabs.push_back(slab);
+        }
+
+        static ptr<ObjectPool> create() {
+            auto pool = new ObjectPool();
+            PoolRegistry::Register([pool]() { return pool->GetStatistics(); });
+            return pool;
+        }
+    };
+
+    /// <summary>
+    /// Gives a class its own ObjectPool by overriding its operator new and delete
+    /// </summary>
+    /// <remarks>
+    /// Derive from this with the class itself, e.g.
+    /// class Position : public IComponent, public Pooled&lt;Position&gt;.
+    /// Classes derived from a pooled class that are bigger than it fall
+    /// back to the global heap. Deleting through a base pointer needs a
+    /// virtual destructor so the right size reaches operator delete.
+    /// </remarks>
+    template <class Type>
+    class Pooled {
+    public:
+        static void * operator new(std::size_t size) {
+            if(size != sizeof(Type)) {
+                return ::operator new(size);
+            }
+            return ObjectPool<Type>::Get().Allocate();
+        }
+
+        static void operator delete(void * memory, std::size_t size) {
+            if(memory == nullptr) {
+                return;
+            }
+            if(size != sizeof(Type)) {
+                ::operator delete(memory);
+                return;
+            }
+            ObjectPool<Type>::Get().Deallocate(memory);
+        }
+    };
+
+}
@@ -0,0 +1,99 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Prefab.hpp"
+#include "Components.hpp"
+
+namespace gquest {
+
+    Prefab::Prefab() : _entries(), _signature(), _archetype(nullptr) { }
+
+    vec<Prefab::Entry> const & Prefab::GetEntries() const {
+        return _entries;
+    }
+
+    ComponentSignature const & Prefab::GetSignature() const {
+        return _signature;
+    }
+
+    void Prefab::Instantiate(ptr<ArchetypeEntity> entity) const {
+        ArchetypeStorage::Get()->Instantiate(*this, entity);
+    }
+
+    void Prefab::Instantiate(ptr<ArchetypeEntity> entity, IVector2 const & position) const {
+        components::Position placed(0, position, false);
+        ArchetypeStorage::Get()->Instantiate(*this, entity, &placed);
+    }
+
+    void Prefab::Instantiate(vec<ptr<ArchetypeEntity>> const & entities, vec<IVector2> const & positions) const {
+        vec<components::Position> placed;
+        placed.reserve(positions.size());
+        vec<ptr<IComponent const>> overrides;
+        overrides.reserve(positions.size());
+        for(auto const& position : positions) {
+            placed.emplace_back(0, position, false);
+            overrides.push_back(&placed.back());
+        }
+        ArchetypeStorage::Get()->Instantiate(*this, entities, overrides);
+    }
+
+    void Prefab::setEntry(idtype component_id, ComponentUPtr component_template, ComponentFactory const & make) {
+        _archetype = nullptr;
+        auto iter = std::lower_bound(std::begin(_signature), std::end(_signature), component_id);
+        auto index = iter - std::begin(_signature);
+        if((iter != std::end(_signature)) && (*iter == component_id)) {
+            _entries[index] = Entry{ component_id, std::move(component_template), make };
+            return;
+        }
+        _signature.insert(iter, component_id);
+        _entries.insert(std::begin(_entries) + index, Entry{ component_id, std::move(component_template), make });
+    }
+
+
+    uptr<PrefabRegistry> PrefabRegistry::_instance = nullptr;
+
+    PrefabRegistry::PrefabRegistry() : _prefabs() { }
+
+    ptr<Prefab> PrefabRegistry::Register(idtype prefab_id) {
+        auto & prefab = _prefabs[prefab_id];
+        if(prefab == nullptr) {
+            prefab = uptr<Prefab>(new Prefab());
+        }
+        return prefab.get();
+    }
+
+    Prefab const & PrefabRegistry::Find(idtype prefab_id) const {
+        auto iter = _prefabs.find(prefab_id);
+        if(iter == std::end(_prefabs)) {
+            throw std::runtime_error("No prefab has been registered under the requested id");
+        }
+        return *iter->second;
+    }
+
+    ptr<PrefabRegistry> PrefabRegistry::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<PrefabRegistry>(new PrefabRegistry());
+        }
+        return _instance.get();
+    }
+
+}
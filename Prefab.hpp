@@ -0,0 +1,153 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "IComponent.hpp"
+#include "Archetype.hpp"
+#include "Vector2.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A set of components that is built once and then stamped onto any number of ArchetypeEntities
+    /// </summary>
+    /// <remarks>
+    /// Components added with Copy are kept as templates and copied straight
+    /// into the archetype's columns. Components whose constructors have side
+    /// effects, like the controllers that register event handlers or queue
+    /// their first command, are added with Construct instead and built anew
+    /// for every instance.
+    /// </remarks>
+    class Prefab {
+    public:
+        /// <summary>
+        /// Makes a heap allocated component for an instance, from a template iff the component has one
+        /// </summary>
+        using ComponentFactory = function<ComponentPtr(ptr<IComponent const> source)>;
+
+        struct Entry {
+            idtype ComponentId;
+            ComponentUPtr Template;
+            ComponentFactory Make;
+        };
+
+    private:
+        friend class ArchetypeStorage;
+
+        vec<Entry> _entries;
+        ComponentSignature _signature;
+
+        /// <summary>
+        /// The archetype every instance lands in, looked up on first use
+        /// </summary>
+        mutable ptr<Archetype> _archetype;
+
+    public:
+        Prefab();
+        Prefab(Prefab const&) = delete;
+        Prefab & operator =(Prefab const&) = delete;
+
+        /// <summary>
+        /// Adds a template that is copied into every instance, replacing any component of the same type
+        /// </summary>
+        template <class ComponentType>
+        Prefab & Copy(ComponentType const& component);
+
+        /// <summary>
+        /// Adds a component that is default constructed for every instance, replacing any component of the same type
+        /// </summary>
+        template <class ComponentType>
+        Prefab & Construct();
+
+        /// <summary>
+        /// Returns the components of the prefab, sorted by component id
+        /// </summary>
+        vec<Entry> const& GetEntries() const;
+        ComponentSignature const& GetSignature() const;
+
+        void Instantiate(ptr<ArchetypeEntity> entity) const;
+
+        /// <summary>
+        /// Instantiates the prefab with its Position moved to a point in system 0
+        /// </summary>
+        void Instantiate(ptr<ArchetypeEntity> entity, IVector2 const& position) const;
+
+        /// <summary>
+        /// Instantiates the prefab once for every position, moving every entity into the prefab's archetype together
+        /// </summary>
+        void Instantiate(vec<ptr<ArchetypeEntity>> const& entities, vec<IVector2> const& positions) const;
+
+    private:
+        void setEntry(idtype component_id, ComponentUPtr component_template, ComponentFactory const& make);
+    };
+
+    template <class ComponentType>
+    inline Prefab & Prefab::Copy(ComponentType const& component) {
+        setEntry(ComponentType::TypeId, ComponentUPtr(new ComponentType(component)),
+            [](ptr<IComponent const> source) -> ComponentPtr {
+                return new ComponentType(*static_cast<ComponentType const*>(source));
+            });
+        return *this;
+    }
+
+    template <class ComponentType>
+    inline Prefab & Prefab::Construct() {
+        setEntry(ComponentType::TypeId, nullptr,
+            [](ptr<IComponent const>) -> ComponentPtr {
+                return new ComponentType();
+            });
+        return *this;
+    }
+
+    /// <summary>
+    /// Holds the prefabs of every kind of entity, by id
+    /// </summary>
+    /// <remarks>
+    /// It starts out empty. Each kind of entity adds its own prefab with a
+    /// static RegisterPrefab, which the game calls while setting up.
+    /// </remarks>
+    class PrefabRegistry {
+    private:
+        hashmap<idtype, uptr<Prefab>> _prefabs;
+
+        static uptr<PrefabRegistry> _instance;
+
+    public:
+        PrefabRegistry();
+        PrefabRegistry(PrefabRegistry const&) = delete;
+        PrefabRegistry & operator =(PrefabRegistry const&) = delete;
+
+        /// <summary>
+        /// Returns the prefab registered under an id, creating an empty one iff there is none yet
+        /// </summary>
+        ptr<Prefab> Register(idtype prefab_id);
+
+        /// <summary>
+        /// Returns the prefab registered under an id, throwing std::runtime_error iff there is none
+        /// </summary>
+        Prefab const& Find(idtype prefab_id) const;
+
+        static ptr<PrefabRegistry> Get();
+    };
+
+}
@@ -38,7 +38,7 @@ namespace gquest {
 
         constexpr Rect() : Left(), Top(), Width(), Height() { }
         constexpr Rect(Type const& left, Type const& top, Type const& width, Type const& height) :
-            Left(left), Top(Top), Width(width), Height(height) { }
+            Left(left), Top(top), Width(width), Height(height) { }
         constexpr Rect(Vector2<Type> const& left_top, Vector2<Type> const& size) :
             Left(left_top.X), Top(left_top.Y), Width(size.X), Height(size.Y) { }
         constexpr Rect(Rect const& rect) : Left(rect.Left), Top(rect.Top), Width(rect.Width), Height(rect.Height) { }
@@ -48,6 +48,14 @@ namespace gquest {
             Left(left_top.X), Top(left_top.Y), Width(size.X), Height(size.Y) { }
         constexpr Rect(Rect && rect) : Left(rect.Left), Top(rect.Top), Width(rect.Width), Height(rect.Height) { }
 
+        inline Rect & operator =(Rect const& rect) {
+            Left = rect.Left;
+            Top = rect.Top;
+            Width = rect.Width;
+            Height = rect.Height;
+            return *this;
+        }
+
         // Implementation based on SFML https://sfml-dev.org
         inline constexpr bool contains(Type const& x, Type const& y) const {
             return
@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "RenderScheduler.hpp"
+
+namespace gquest {
+
+    RenderScheduler::RenderScheduler(uint_ max_frames_per_second) :
+        _interval(), _lastFrame(), _dirty(false), _forced(false), _frames(0), _coalesced(0) {
+        SetMaxFramesPerSecond(max_frames_per_second);
+    }
+
+    void RenderScheduler::SetMaxFramesPerSecond(uint_ max_frames_per_second) {
+        if(max_frames_per_second == 0) {
+            _interval = clock::duration::zero();
+        } else {
+            _interval = std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / max_frames_per_second;
+        }
+    }
+
+    uint_ RenderScheduler::GetMaxFramesPerSecond() const {
+        if(_interval == clock::duration::zero()) {
+            return 0;
+        }
+        return static_cast<uint_>(std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / _interval);
+    }
+
+    void RenderScheduler::MarkDirty() {
+        _dirty = true;
+    }
+
+    void RenderScheduler::ForceNextFrame() {
+        _forced = true;
+    }
+
+    bool RenderScheduler::ShouldRender(bool present) {
+        if(!present && !_forced && !_dirty) {
+            return false;
+        }
+        auto now = clock::now();
+        if(!present && !_forced && ((now - _lastFrame) < _interval)) {
+            ++_coalesced;
+            return false;
+        }
+        _lastFrame = now;
+        _dirty = false;
+        _forced = false;
+        ++_frames;
+        return true;
+    }
+
+    ui64 RenderScheduler::GetFramesRendered() const {
+        return _frames;
+    }
+
+    ui64 RenderScheduler::GetTicksCoalesced() const {
+        return _coalesced;
+    }
+
+}
@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// How many frames a second are drawn at most, unless told otherwise
+    /// </summary>
+    constexpr uint_ DEFAULT_MAX_FRAMES_PER_SECOND = 60;
+
+    /// <summary>
+    /// Decides which simulated ticks get drawn, so that drawing never holds the simulation back
+    /// </summary>
+    /// <remarks>
+    /// Ticks that changed something mark the scheduler dirty, and a frame
+    /// is drawn once at least a frame interval has passed since the last
+    /// one. Every tick in between is folded into that frame, since a frame
+    /// always draws the whole current state. A frame that has to be
+    /// presented, such as the last one before waiting on the player, is
+    /// always drawn, as is the next one after ForceNextFrame(), which lets
+    /// an animation show each of its steps.
+    /// </remarks>
+    class RenderScheduler {
+    public:
+        using clock = std::chrono::steady_clock;
+
+    private:
+        clock::duration _interval;
+        clock::time_point _lastFrame;
+        bool _dirty;
+        bool _forced;
+        ui64 _frames;
+        ui64 _coalesced;
+
+    public:
+        RenderScheduler(uint_ max_frames_per_second = DEFAULT_MAX_FRAMES_PER_SECOND);
+        RenderScheduler(RenderScheduler const&) = delete;
+        RenderScheduler & operator =(RenderScheduler const&) = delete;
+
+        /// <summary>
+        /// Caps how many frames are drawn a second, where 0 draws every tick that changed something
+        /// </summary>
+        void SetMaxFramesPerSecond(uint_ max_frames_per_second);
+        uint_ GetMaxFramesPerSecond() const;
+
+        /// <summary>
+        /// Notes that the tick just simulated changed something that has not been drawn yet
+        /// </summary>
+        void MarkDirty();
+
+        /// <summary>
+        /// Makes the next ShouldRender() draw the frame whatever the cap
+        /// </summary>
+        void ForceNextFrame();
+
+        /// <summary>
+        /// Returns true iff a frame should be drawn now, in which case it counts as drawn
+        /// </summary>
+        /// <param name="present">Whether the current state has to be shown, whatever the cap and even if nothing changed</param>
+        bool ShouldRender(bool present);
+
+        ui64 GetFramesRendered() const;
+
+        /// <summary>
+        /// Returns how many ticks went undrawn because of the cap, their changes showing up in a later frame
+        /// </summary>
+        ui64 GetTicksCoalesced() const;
+    };
+
+}
@@ -0,0 +1,211 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Replay.hpp"
+
+namespace gquest {
+
+    namespace {
+
+        constexpr ui32 LogMagic = 0x4C495147; // "GQIL"
+        constexpr ui16 LogVersion = 1;
+
+        enum class RecordKind : ui8 { Frame = 1, Checksum = 2 };
+
+        constexpr ui8 FrameActed = 0x1;
+        constexpr ui8 FramePlayerActed = 0x2;
+
+        // Bounds on lengths read from a log, so a damaged one fails to read instead of allocating without limit
+        constexpr ui32 MaxStringLength = 4096;
+        constexpr ui32 MaxReservedCommands = 4096;
+
+        template <class Type>
+        void write(std::ostream & out, Type const& value) {
+            out.write(reinterpret_cast<char const*>(&value), sizeof(Type));
+        }
+
+        template <class Type>
+        Type read(std::istream & in) {
+            Type value;
+            if(!in.read(reinterpret_cast<char *>(&value), sizeof(Type))) {
+                throw std::runtime_error("Input log ends in the middle of a record");
+            }
+            return value;
+        }
+
+        void writeCommand(std::ostream & out, Command const& command) {
+            write<ui64>(out, command.GetWhen());
+            write<ui64>(out, static_cast<ui64>(command.GetCommandType()));
+            write<ui8>(out, static_cast<ui8>(command.GetArgumentCount()));
+            for(uint_ i = 0; i < command.GetArgumentCount(); ++i) {
+                auto argument = command.GetArgument(i);
+                write<ui8>(out, static_cast<ui8>(argument.GetType()));
+                if(argument.GetType() == ArgumentType::String) {
+                    string text;
+                    argument.get(text);
+                    write<ui32>(out, static_cast<ui32>(text.size()));
+                    for(auto c : text) {
+                        write<ui16>(out, static_cast<ui16>(c));
+                    }
+                } else {
+                    write<ui64>(out, argument.GetValue().UInt);
+                }
+            }
+        }
+
+        Command readCommand(std::istream & in) {
+            auto when = read<ui64>(in);
+            auto type = read<ui64>(in);
+            if(type >= CommandTypeCount) {
+                throw std::runtime_error("Input log has a command of an unknown type");
+            }
+            auto count = read<ui8>(in);
+            if(count > Command::MaxArguments) {
+                throw std::runtime_error("Input log has a command with too many arguments");
+            }
+            vec<CommandArgument> arguments;
+            arguments.reserve(count);
+            for(ui8 i = 0; i < count; ++i) {
+                auto argument_type = static_cast<ArgumentType>(read<ui8>(in));
+                if(argument_type > ArgumentType::String) {
+                    throw std::runtime_error("Input log has an argument of an unknown type");
+                }
+                if(argument_type == ArgumentType::String) {
+                    auto length = read<ui32>(in);
+                    if(length > MaxStringLength) {
+                        throw std::runtime_error("Input log has a string argument that is too long");
+                    }
+                    string text(length, L'\0');
+                    for(auto & c : text) {
+                        c = static_cast<wchar_t>(read<ui16>(in));
+                    }
+                    arguments.push_back(CommandArgument(text));
+                } else {
+                    CommandArgument::Value value;
+                    value.UInt = read<ui64>(in);
+                    arguments.push_back(CommandArgument(argument_type, value));
+                }
+            }
+            return Command::WithArguments(when, static_cast<CommandType>(type), arguments);
+        }
+
+    }
+
+    InputLog::InputLog() : Seed(0), PlayArea(), ChecksumInterval(0) { }
+
+    InputLog InputLog::Read(string const& path) {
+        std::ifstream in(path, std::ios::binary);
+        if(!in) {
+            throw std::runtime_error("Could not open the input log");
+        }
+        if(read<ui32>(in) != LogMagic) {
+            throw std::runtime_error("Not an input log");
+        }
+        if(read<ui16>(in) != LogVersion) {
+            throw std::runtime_error("Input log was written by a different version");
+        }
+        InputLog log;
+        log.Seed = read<ui32>(in);
+        log.PlayArea.Left = read<i64>(in);
+        log.PlayArea.Top = read<i64>(in);
+        log.PlayArea.Width = read<i64>(in);
+        log.PlayArea.Height = read<i64>(in);
+        log.ChecksumInterval = read<ui64>(in);
+        ui8 kind;
+        while(in.read(reinterpret_cast<char *>(&kind), sizeof(kind))) {
+            switch(static_cast<RecordKind>(kind)) {
+            case RecordKind::Frame:
+            {
+                InputFrame frame;
+                frame.Tick = read<ui64>(in);
+                auto flags = read<ui8>(in);
+                frame.Acted = (flags & FrameActed) != 0;
+                frame.PlayerActed = (flags & FramePlayerActed) != 0;
+                auto count = read<ui32>(in);
+                // A count past the end of the log runs out of records below rather than being allocated up front
+                frame.Commands.reserve(std::min(count, MaxReservedCommands));
+                for(ui32 i = 0; i < count; ++i) {
+                    frame.Commands.push_back(readCommand(in));
+                }
+                log.Frames.push_back(std::move(frame));
+                break;
+            }
+            case RecordKind::Checksum:
+            {
+                StateChecksum checksum;
+                checksum.Tick = read<ui64>(in);
+                checksum.Value = read<ui64>(in);
+                log.Checksums.push_back(checksum);
+                break;
+            }
+            default:
+                throw std::runtime_error("Input log has a record of an unknown kind");
+            }
+        }
+        return log;
+    }
+
+    InputRecorder::InputRecorder(string const& path, ui32 seed, IRect const& play_area, uint_ checksum_interval) :
+        _out(path, std::ios::binary | std::ios::trunc), _frame(), _wroteFrame(false) {
+        if(!_out) {
+            throw std::runtime_error("Could not create the input log");
+        }
+        write<ui32>(_out, LogMagic);
+        write<ui16>(_out, LogVersion);
+        write<ui32>(_out, seed);
+        write<i64>(_out, play_area.Left);
+        write<i64>(_out, play_area.Top);
+        write<i64>(_out, play_area.Width);
+        write<i64>(_out, play_area.Height);
+        write<ui64>(_out, checksum_interval);
+        _out.flush();
+    }
+
+    void InputRecorder::Record(Command const& command) {
+        _frame.Commands.push_back(command);
+    }
+
+    void InputRecorder::EndFrame(uint_ tick, bool acted, bool player_acted) {
+        if(!acted && _frame.Commands.empty() && _wroteFrame && (_frame.Tick == tick)) {
+            return;
+        }
+        _wroteFrame = true;
+        _frame.Tick = tick;
+        write<ui8>(_out, static_cast<ui8>(RecordKind::Frame));
+        write<ui64>(_out, tick);
+        write<ui8>(_out, (acted ? FrameActed : 0) | (player_acted ? FramePlayerActed : 0));
+        write<ui32>(_out, static_cast<ui32>(_frame.Commands.size()));
+        for(auto const& command : _frame.Commands) {
+            writeCommand(_out, command);
+        }
+        _out.flush();
+        _frame.Commands.clear();
+    }
+
+    void InputRecorder::RecordChecksum(uint_ tick, ui64 value) {
+        write<ui8>(_out, static_cast<ui8>(RecordKind::Checksum));
+        write<ui64>(_out, tick);
+        write<ui64>(_out, value);
+        _out.flush();
+    }
+
+}
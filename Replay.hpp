@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "Command.hpp"
+#include "Rect.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// How many ticks apart the world is checksummed while recording, unless told otherwise
+    /// </summary>
+    constexpr uint_ DEFAULT_CHECKSUM_INTERVAL = 100;
+
+    /// <summary>
+    /// The commands the player queued in one Update(), and the tick they were queued on
+    /// </summary>
+    /// <remarks>
+    /// Frames in which nothing was done are kept too, since an Update()
+    /// simulates the current tick whether or not the player did anything.
+    /// </remarks>
+    struct InputFrame {
+        uint_ Tick;
+        bool Acted;
+        bool PlayerActed;
+        vec<Command> Commands;
+    };
+
+    /// <summary>
+    /// A checksum of the world taken on the first tick simulated at or past a multiple of the checksum interval
+    /// </summary>
+    struct StateChecksum {
+        uint_ Tick;
+        ui64 Value;
+    };
+
+    /// <summary>
+    /// Everything needed to play a session back: the seed, the play area, and every frame of player input
+    /// </summary>
+    /// <remarks>
+    /// On disk the log is a small header followed by one record per input
+    /// frame or checksum, in the order they happened. Commands are written
+    /// field by field, and string arguments as their text, so a log does
+    /// not depend on the layout of Command or on the StringTable of the
+    /// session that wrote it.
+    /// </remarks>
+    class InputLog {
+    public:
+        ui32 Seed;
+        IRect PlayArea;
+        uint_ ChecksumInterval;
+        vec<InputFrame> Frames;
+        vec<StateChecksum> Checksums;
+
+        InputLog();
+
+        /// <summary>
+        /// Reads a whole log, throwing std::runtime_error iff the file can't be opened or isn't a complete log
+        /// </summary>
+        static InputLog Read(string const& path);
+    };
+
+    /// <summary>
+    /// Writes an InputLog out as the session goes, a frame at a time
+    /// </summary>
+    /// <remarks>
+    /// Commands are buffered by Record() until EndFrame() writes them out
+    /// as one frame. A frame in which nothing was done is skipped iff a
+    /// frame was already written for its tick, as simulating a tick again
+    /// changes nothing. The file is flushed after every record so a crash
+    /// loses at most the frame that was being played.
+    /// </remarks>
+    class InputRecorder {
+    private:
+        std::ofstream _out;
+        InputFrame _frame;
+        bool _wroteFrame;
+
+    public:
+        /// <summary>
+        /// Starts a log with its header, throwing std::runtime_error iff the file can't be created
+        /// </summary>
+        InputRecorder(string const& path, ui32 seed, IRect const& play_area, uint_ checksum_interval);
+        InputRecorder(InputRecorder const&) = delete;
+        InputRecorder & operator =(InputRecorder const&) = delete;
+
+        void Record(Command const& command);
+        void EndFrame(uint_ tick, bool acted, bool player_acted);
+        void RecordChecksum(uint_ tick, ui64 value);
+    };
+
+    /// <summary>
+    /// How a headless replay went
+    /// </summary>
+    struct ReplayResult {
+        uint_ Frames;
+        uint_ Ticks;
+        uint_ ChecksumsMatched;
+        bool Diverged;
+
+        /// <summary>
+        /// The tick the replay stopped matching the log on, iff Diverged
+        /// </summary>
+        uint_ DivergedAt;
+        f64 Seconds;
+    };
+
+}
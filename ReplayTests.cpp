@@ -0,0 +1,140 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include <random>
+#include "Tests.hpp"
+#include "Game.hpp"
+#include "Replay.hpp"
+
+namespace gquest {
+
+    namespace tests {
+
+        namespace {
+
+            constexpr ui32 RecordedSeed = 7;
+            constexpr uint_ RecordedChecksumInterval = 10;
+
+            /// <summary>
+            /// Returns the commands the player gives in one frame of the scripted session, as the key handlers would queue them
+            /// </summary>
+            vec<Command> scriptedCommands(uint_ now, IRect const& play_area, std::mt19937_64 & random) {
+                static CommandType const moves[] = {
+                    CommandType::MoveLeft, CommandType::MoveRight, CommandType::MoveUp, CommandType::MoveDown,
+                    CommandType::MoveLeftUp, CommandType::MoveRightUp, CommandType::MoveLeftDown, CommandType::MoveRightDown,
+                };
+                vec<Command> commands;
+                auto choice = random() % 20;
+                if(choice < 12) {
+                    commands.push_back(Command(now + 1, moves[random() % 8]));
+                } else if(choice < 17) {
+                    commands.push_back(Command(now, CommandType::Wait));
+                } else if(choice < 19) {
+                    commands.push_back(Command(now + 1, moves[random() % 8]));
+                    commands.push_back(Command(now, CommandType::LivelySplatter_Spawn,
+                        static_cast<int_>(play_area.Left + random() % play_area.Width),
+                        static_cast<int_>(play_area.Top + random() % play_area.Height)));
+                } else {
+                    commands.push_back(Command(now, CommandType::DEBUG_BecomeSmiley));
+                    commands.push_back(Command(now + 19, CommandType::DEBUG_BecomePlayer));
+                }
+                return commands;
+            }
+
+            bool sameCommand(Command const& lhs, Command const& rhs) {
+                if((lhs.GetWhen() != rhs.GetWhen()) || (lhs.GetCommandType() != rhs.GetCommandType()) || (lhs.GetArgumentCount() != rhs.GetArgumentCount())) {
+                    return false;
+                }
+                for(uint_ index = 0; index < lhs.GetArgumentCount(); ++index) {
+                    int_ lhs_value = 0;
+                    int_ rhs_value = 0;
+                    if(lhs.GetArgument(index, lhs_value) != rhs.GetArgument(index, rhs_value) || (lhs_value != rhs_value)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            ReplayResult replay(InputLog const& log) {
+                auto game = uptr<Game>(Game::Get());
+                return game->Replay(log);
+            }
+
+        }
+
+        void ReplayMatchesRecording() {
+            // A headless session is recorded to a file, read back, and played on a fresh Game, which has to reach every checksum
+            string const path = L"ReplayTests.log";
+            IRect const play_area(25, 1, 94, 34);
+            vec<InputFrame> played;
+            uint_ recorded_ticks = 0;
+            {
+                auto game = uptr<Game>(Game::Get());
+                game->Seed(RecordedSeed);
+                game->StartRecording(path, RecordedChecksumInterval);
+                game->StartHeadless(play_area);
+                std::mt19937_64 random(1);
+                for(int frame = 0; frame < 400; ++frame) {
+                    played.push_back(InputFrame{ game->Now(), true, true, scriptedCommands(game->Now(), play_area, random) });
+                    game->PlayFrame(played.back());
+                }
+                recorded_ticks = game->Now();
+            }
+            auto log = InputLog::Read(path);
+            _wremove(path.c_str());
+
+            Check(log.Seed == RecordedSeed, "The log has the wrong seed");
+            Check(log.ChecksumInterval == RecordedChecksumInterval, "The log has the wrong checksum interval");
+            Check(log.Frames.size() == played.size(), "The log does not have a frame for every frame played");
+            for(uint_ index = 0; index < played.size(); ++index) {
+                auto const& expected = played[index];
+                auto const& actual = log.Frames[index];
+                Check((actual.Tick == expected.Tick) && (actual.Acted == expected.Acted) && (actual.PlayerActed == expected.PlayerActed),
+                    "A frame was read back with the wrong tick or flags");
+                Check(actual.Commands.size() == expected.Commands.size(), "A frame was read back with the wrong number of commands");
+                for(uint_ command = 0; command < expected.Commands.size(); ++command) {
+                    Check(sameCommand(actual.Commands[command], expected.Commands[command]), "A command was read back differently");
+                }
+            }
+            Check(log.Checksums.size() > 10, "The session did not record enough checksums to compare");
+
+            auto result = replay(log);
+            Check(!result.Diverged, "The replay diverged from the recording");
+            Check(result.Frames == log.Frames.size(), "The replay stopped before the last frame");
+            Check(result.ChecksumsMatched == log.Checksums.size(), "The replay did not reach every checksum");
+            Check(result.Ticks == recorded_ticks, "The replay ended on a different tick");
+
+            // Without this the test would also pass if the checksums were never compared
+            log.Seed ^= 1;
+            result = replay(log);
+            Check(result.Diverged, "A replay from the wrong seed was not caught");
+
+            // Nor would a replay of only some of the frames match every checksum
+            log.Seed ^= 1;
+            log.Frames.resize(log.Frames.size() / 2);
+            result = replay(log);
+            Check(result.Diverged, "A replay that stopped short of the recorded checksums was not caught");
+        }
+
+    }
+
+}
@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "SimulationScheduler.hpp"
+#include "World.hpp"
+
+namespace gquest {
+
+    SimulationScheduler::SimulationScheduler() : _systems(), _waves(), _dirty(false) { }
+
+    void SimulationScheduler::AddSystem(SimulationSystemUPtr system) {
+        _systems.push_back(std::move(system));
+        _dirty = true;
+    }
+
+    bool SimulationScheduler::RemoveSystem(idtype system_id) {
+        auto iter = std::find_if(std::begin(_systems), std::end(_systems),
+            [system_id](SimulationSystemUPtr const& system) { return system->GetId() == system_id; });
+        if(iter == std::end(_systems)) {
+            return false;
+        }
+        _systems.erase(iter);
+        _dirty = true;
+        return true;
+    }
+
+    ptr<ISimulationSystem> SimulationScheduler::GetSystem(idtype system_id) const {
+        for(auto const& system : _systems) {
+            if(system->GetId() == system_id) {
+                return system.get();
+            }
+        }
+        return nullptr;
+    }
+
+    vec<vec<ptr<ISimulationSystem>>> const & SimulationScheduler::GetWaves() {
+        if(_dirty) {
+            buildWaves();
+        }
+        return _waves;
+    }
+
+    void SimulationScheduler::Run(World & world, uint_ now, JobPool & pool) {
+        for(auto const& wave : GetWaves()) {
+            if((wave.size() == 1) || wave.front()->IsExclusive()) {
+                for(auto system : wave) {
+                    system->Run(world, now);
+                }
+                continue;
+            }
+            vec<JobPool::Job> jobs;
+            jobs.reserve(wave.size());
+            for(auto system : wave) {
+                jobs.push_back([system, &world, now]() { system->Run(world, now); });
+            }
+            world.RunJobsInParallel(jobs, pool);
+        }
+    }
+
+    bool SimulationScheduler::Conflicts(ISimulationSystem const & lhs, ISimulationSystem const & rhs) {
+        if(lhs.IsExclusive() || rhs.IsExclusive()) {
+            return true;
+        }
+        auto lhs_writes = lhs.GetWrites();
+        auto rhs_writes = rhs.GetWrites();
+        return (lhs_writes & (rhs.GetReads() | rhs_writes)).any() ||
+            (rhs_writes & lhs.GetReads()).any();
+    }
+
+    void SimulationScheduler::buildWaves() {
+        _waves.clear();
+        vec<uint_> levels(_systems.size(), 0);
+        for(uint_ i = 0; i < _systems.size(); ++i) {
+            for(uint_ j = 0; j < i; ++j) {
+                if((levels[j] + 1 > levels[i]) && Conflicts(*_systems[j], *_systems[i])) {
+                    levels[i] = levels[j] + 1;
+                }
+            }
+            if(levels[i] >= _waves.size()) {
+                _waves.resize(levels[i] + 1);
+            }
+            _waves[levels[i]].push_back(_systems[i].get());
+        }
+        _dirty = false;
+    }
+
+}
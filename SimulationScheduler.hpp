@@ -0,0 +1,88 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "ISimulationSystem.hpp"
+#include "JobPool.hpp"
+
+namespace gquest {
+
+    class World;
+
+    /// <summary>
+    /// Runs simulation systems every tick, running the ones that do not conflict at the same time
+    /// </summary>
+    /// <remarks>
+    /// Two systems conflict when one writes a component the other reads or
+    /// writes, or when either is exclusive. A system waits for every
+    /// conflicting system added before it, so the result is the same as
+    /// running them all in the order they were added.
+    ///
+    /// The systems are split into waves, where a wave holds the systems
+    /// whose dependencies are all in earlier waves. Each wave runs as one
+    /// parallel section of the World. The waves are worked out again
+    /// whenever a system is added or removed.
+    /// </remarks>
+    class SimulationScheduler {
+    private:
+        vec<SimulationSystemUPtr> _systems;
+        vec<vec<ptr<ISimulationSystem>>> _waves;
+        bool _dirty;
+
+    public:
+        SimulationScheduler();
+        SimulationScheduler(SimulationScheduler const&) = delete;
+        SimulationScheduler & operator =(SimulationScheduler const&) = delete;
+
+        /// <summary>
+        /// Adds a system to run after every system already added that it conflicts with
+        /// </summary>
+        void AddSystem(SimulationSystemUPtr system);
+
+        /// <summary>
+        /// Removes a system iff it has been added
+        /// </summary>
+        bool RemoveSystem(idtype system_id);
+
+        ptr<ISimulationSystem> GetSystem(idtype system_id) const;
+
+        /// <summary>
+        /// Returns the systems grouped into the waves they run in
+        /// </summary>
+        vec<vec<ptr<ISimulationSystem>>> const& GetWaves();
+
+        /// <summary>
+        /// Runs every system once
+        /// </summary>
+        void Run(World & world, uint_ now, JobPool & pool = *JobPool::Get());
+
+        /// <summary>
+        /// Returns true iff two systems may not run at the same time
+        /// </summary>
+        static bool Conflicts(ISimulationSystem const& lhs, ISimulationSystem const& rhs);
+
+    private:
+        void buildWaves();
+    };
+
+}
@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Tests.hpp"
+#include "SimulationScheduler.hpp"
+#include "Components.hpp"
+#include "World.hpp"
+
+namespace gquest {
+
+    namespace tests {
+
+        namespace {
+
+            /// <summary>
+            /// A simulation system made of its declared access and a callback
+            /// </summary>
+            class MockSystem : public ISimulationSystem {
+            private:
+                idtype _id;
+                ComponentMask _reads;
+                ComponentMask _writes;
+                bool _exclusive;
+                function<void()> _run;
+
+            public:
+                MockSystem(idtype id, ComponentMask const& reads, ComponentMask const& writes, bool exclusive, function<void()> const& run = nullptr) :
+                    _id(id), _reads(reads), _writes(writes), _exclusive(exclusive), _run(run) { }
+
+                virtual idtype GetId() const override { return _id; }
+                virtual ComponentMask GetReads() const override { return _reads; }
+                virtual ComponentMask GetWrites() const override { return _writes; }
+                virtual bool IsExclusive() const override { return _exclusive; }
+
+                virtual void Run(World &, uint_) override {
+                    if(_run) {
+                        _run();
+                    }
+                }
+            };
+
+            SimulationSystemUPtr mock(idtype id, ComponentMask const& reads, ComponentMask const& writes, bool exclusive = false, function<void()> const& run = nullptr) {
+                return SimulationSystemUPtr(new MockSystem(id, reads, writes, exclusive, run));
+            }
+
+            bool waveIs(vec<ptr<ISimulationSystem>> const& wave, vec<idtype> const& ids) {
+                if(wave.size() != ids.size()) {
+                    return false;
+                }
+                for(uint_ i = 0; i < wave.size(); ++i) {
+                    if(wave[i]->GetId() != ids[i]) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+        }
+
+        void SimulationSchedulerBuildsWaves() {
+            auto position = MaskOf<components::Position>();
+            auto cell = MaskOf<components::Cell>();
+            auto name = MaskOf<components::Name>();
+            SimulationScheduler scheduler;
+            scheduler.AddSystem(mock("A"_id, ComponentMask(), position));
+            scheduler.AddSystem(mock("B"_id, ComponentMask(), cell));
+            scheduler.AddSystem(mock("C"_id, position, ComponentMask()));
+            scheduler.AddSystem(mock("D"_id, ComponentMask(), ComponentMask(), true));
+            scheduler.AddSystem(mock("E"_id, ComponentMask(), name));
+
+            auto const& waves = scheduler.GetWaves();
+            Check(waves.size() == 4, "Expected four waves");
+            Check(waveIs(waves[0], { "A"_id, "B"_id }), "Systems writing different components are not in one wave");
+            Check(waveIs(waves[1], { "C"_id }), "A reader of Position is not after its writer");
+            Check(waveIs(waves[2], { "D"_id }), "An exclusive system does not have a wave to itself");
+            Check(waveIs(waves[3], { "E"_id }), "A system added after an exclusive one does not wait for it");
+
+            Check(scheduler.RemoveSystem("D"_id), "RemoveSystem missed an added system");
+            Check(scheduler.GetWaves().size() == 2, "The waves were not rebuilt after a removal");
+            Check(waveIs(scheduler.GetWaves()[0], { "A"_id, "B"_id, "E"_id }), "E did not join the first wave once D was gone");
+        }
+
+        void SimulationSchedulerRunsWaveConcurrently() {
+            // A and B each wait for the other to start, which only ever happens if the wave really runs them at once
+            std::atomic<int> arrived(0);
+            std::atomic<bool> met_a(false);
+            std::atomic<bool> met_b(false);
+            std::mutex order_mutex;
+            vec<idtype> order;
+            auto record = [&](idtype id) {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(id);
+            };
+            auto rendezvous = [&](idtype id, std::atomic<bool> & met) {
+                ++arrived;
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while((arrived.load() < 2) && (std::chrono::steady_clock::now() < deadline)) {
+                    std::this_thread::yield();
+                }
+                met = arrived.load() >= 2;
+                record(id);
+            };
+
+            EntityRegistry registry;
+            World world(&registry);
+            JobPool pool(1);
+            SimulationScheduler scheduler;
+            scheduler.AddSystem(mock("A"_id, ComponentMask(), MaskOf<components::Position>(), false, [&]() { rendezvous("A"_id, met_a); }));
+            scheduler.AddSystem(mock("B"_id, ComponentMask(), MaskOf<components::Cell>(), false, [&]() { rendezvous("B"_id, met_b); }));
+            scheduler.AddSystem(mock("C"_id, MaskOf<components::Position>(), ComponentMask(), false, [&]() { record("C"_id); }));
+            scheduler.Run(world, 1, pool);
+
+            Check(met_a && met_b, "The systems of a wave did not run at the same time");
+            Check((order.size() == 3) && (order[2] == "C"_id), "A later wave ran before an earlier one had finished");
+            Check(!world.IsIterating(), "The World was left in its parallel section");
+        }
+
+    }
+
+}
@@ -0,0 +1,69 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "SimulationSystems.hpp"
+#include "Components.hpp"
+#include "World.hpp"
+#include "CommandScheduler.hpp"
+
+namespace gquest::simulation {
+
+    constexpr idtype LivelySplatterSystem::TypeId;
+
+    LivelySplatterSystem::LivelySplatterSystem() :
+        _writes(MaskOf<components::Position, components::LivelySplatterController>()), _due(), _executor() { }
+
+    idtype LivelySplatterSystem::GetId() const {
+        return TypeId;
+    }
+
+    ComponentMask LivelySplatterSystem::GetReads() const {
+        return ComponentMask();
+    }
+
+    ComponentMask LivelySplatterSystem::GetWrites() const {
+        return _writes;
+    }
+
+    bool LivelySplatterSystem::IsExclusive() const {
+        return true;
+    }
+
+    void LivelySplatterSystem::Run(World & world, uint_ now) {
+        world.AdvanceActiveSystems(now);
+        _due.clear();
+        CommandScheduler::Get()->Advance(now, _due);
+        auto registry = world.GetRegistry();
+        for(auto handle : _due) {
+            if(!world.IsEntityActive(handle)) {
+                continue;
+            }
+            auto entity = registry->Resolve(handle);
+            auto controller = entity->TryGet<components::LivelySplatterController>();
+            if(controller != nullptr) {
+                _executor.Gather(entity, controller, now);
+            }
+        }
+        _executor.Run(now);
+    }
+
+}
@@ -0,0 +1,65 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "ISimulationSystem.hpp"
+#include "EntityHandle.hpp"
+#include "CommandBatch.hpp"
+
+namespace gquest::simulation {
+
+    /// <summary>
+    /// Executes the due commands of every LivelySplatterController in star systems that are awake
+    /// </summary>
+    /// <remarks>
+    /// Only the entities the CommandScheduler hands out for the tick are
+    /// looked at, so idle splatters cost nothing. Their due commands are
+    /// gathered into a CommandBatchExecutor, so all of the tick's moves run
+    /// as a single loop. Wakeups of entities in
+    /// dormant systems are dropped; Game re-schedules them when it catches
+    /// the system up.
+    ///
+    /// Exclusive, since the commands use Game::GetRandom() and the system
+    /// drives the World's dormancy bookkeeping.
+    /// </remarks>
+    class LivelySplatterSystem : public ISimulationSystem {
+    public:
+        static constexpr idtype TypeId = "LivelySplatterSystem"_id;
+
+    private:
+        ComponentMask _writes;
+        vec<EntityHandle> _due;
+        CommandBatchExecutor _executor;
+
+    public:
+        LivelySplatterSystem();
+
+        // Inherited via ISimulationSystem
+        virtual idtype GetId() const override;
+        virtual ComponentMask GetReads() const override;
+        virtual ComponentMask GetWrites() const override;
+        virtual bool IsExclusive() const override;
+        virtual void Run(World & world, uint_ now) override;
+    };
+
+}
@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "SpatialGrid.hpp"
+
+namespace gquest {
+
+    SpatialGrid::SpatialGrid(int_ cell_size) : _cellSize(cell_size > 0 ? cell_size : DefaultCellSize) { }
+
+    void SpatialGrid::Insert(ptr<IEntity> entity, IVector2 const & position) {
+        auto iter = _entries.find(entity);
+        if(iter != std::end(_entries)) {
+            Update(entity, position);
+            return;
+        }
+        auto & entry = _entries[entity];
+        entry.Position = position;
+        link(entity, entry);
+    }
+
+    void SpatialGrid::Update(ptr<IEntity> entity, IVector2 const & position) {
+        auto iter = _entries.find(entity);
+        if(iter == std::end(_entries)) {
+            return;
+        }
+        auto & entry = iter->second;
+        entry.Position = position;
+        if(cellKey(cellCoord(position.X), cellCoord(position.Y)) != entry.Cell) {
+            unlink(entity, entry);
+            link(entity, entry);
+        } else {
+            _cells[entry.Cell][entry.Slot].Position = position;
+        }
+    }
+
+    void SpatialGrid::Remove(ptr<IEntity> entity) {
+        auto iter = _entries.find(entity);
+        if(iter == std::end(_entries)) {
+            return;
+        }
+        unlink(entity, iter->second);
+        _entries.erase(iter);
+    }
+
+    bool SpatialGrid::Contains(ptr<IEntity> entity) const {
+        return _entries.find(entity) != std::end(_entries);
+    }
+
+    uint_ SpatialGrid::Size() const {
+        return _entries.size();
+    }
+
+    void SpatialGrid::Clear() {
+        _cells.clear();
+        _entries.clear();
+    }
+
+    void SpatialGrid::QueryPoint(IVector2 const & position, vec<ptr<IEntity>> & results) const {
+        query(position.X, position.Y, position.X, position.Y,
+            [&](IVector2 const& p) { return (p.X == position.X) && (p.Y == position.Y); },
+            results);
+    }
+
+    void SpatialGrid::QueryRect(IRect const & area, vec<ptr<IEntity>> & results) const {
+        auto min_x = std::min(area.Left, area.Left + area.Width);
+        auto max_x = std::max(area.Left, area.Left + area.Width) - 1;
+        auto min_y = std::min(area.Top, area.Top + area.Height);
+        auto max_y = std::max(area.Top, area.Top + area.Height) - 1;
+        query(min_x, min_y, max_x, max_y,
+            [&](IVector2 const& p) { return area.contains(p); },
+            results);
+    }
+
+    void SpatialGrid::QueryRadius(IVector2 const & center, int_ radius, vec<ptr<IEntity>> & results) const {
+        if(radius < 0) {
+            return;
+        }
+        auto radius2 = radius * radius;
+        query(center.X - radius, center.Y - radius, center.X + radius, center.Y + radius,
+            [&](IVector2 const& p) {
+                auto dx = p.X - center.X;
+                auto dy = p.Y - center.Y;
+                return dx * dx + dy * dy <= radius2;
+            },
+            results);
+    }
+
+    int_ SpatialGrid::cellCoord(int_ value) const {
+        auto cell = value / _cellSize;
+        if((value % _cellSize != 0) && (value < 0)) {
+            --cell;
+        }
+        return cell;
+    }
+
+    ui64 SpatialGrid::cellKey(int_ cell_x, int_ cell_y) {
+        return (static_cast<ui64>(static_cast<ui32>(cell_x)) << 32) | static_cast<ui64>(static_cast<ui32>(cell_y));
+    }
+
+    void SpatialGrid::link(ptr<IEntity> entity, Entry & entry) {
+        entry.Cell = cellKey(cellCoord(entry.Position.X), cellCoord(entry.Position.Y));
+        auto & cell = _cells[entry.Cell];
+        entry.Slot = cell.size();
+        cell.push_back(Occupant{ entity, entry.Position });
+    }
+
+    void SpatialGrid::unlink(ptr<IEntity> entity, Entry const& entry) {
+        auto iter = _cells.find(entry.Cell);
+        auto & cell = iter->second;
+        if(entry.Slot + 1 != cell.size()) {
+            cell[entry.Slot] = cell.back();
+            _entries[cell[entry.Slot].Entity].Slot = entry.Slot;
+        }
+        cell.pop_back();
+        if(cell.empty()) {
+            _cells.erase(iter);
+        }
+    }
+
+}
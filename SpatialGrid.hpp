@@ -0,0 +1,129 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+#include "Vector2.hpp"
+#include "Rect.hpp"
+
+namespace gquest {
+
+    class IEntity;
+
+    /// <summary>
+    /// A uniform grid that buckets entities by their position within a single system
+    /// </summary>
+    /// <remarks>
+    /// Cells are square and only exist while something is in them, so a
+    /// sparse system costs no more than the entities it holds. Queries only
+    /// look at the cells that overlap the area being asked about, and every
+    /// cell keeps its entities' positions next to them so that testing one
+    /// needs no further lookup.
+    /// </remarks>
+    class SpatialGrid {
+    public:
+        static constexpr int_ DefaultCellSize = 8;
+
+    private:
+        struct Entry {
+            IVector2 Position;
+            ui64 Cell;
+            uint_ Slot;
+        };
+
+        struct Occupant {
+            ptr<IEntity> Entity;
+            IVector2 Position;
+        };
+
+        int_ _cellSize;
+        hashmap<ui64, vec<Occupant>> _cells;
+        hashmap<ptr<IEntity>, Entry> _entries;
+
+    public:
+        SpatialGrid(int_ cell_size = DefaultCellSize);
+
+        /// <summary>
+        /// Adds an entity at a position, or moves it there if it is already in the grid
+        /// </summary>
+        void Insert(ptr<IEntity> entity, IVector2 const& position);
+
+        /// <summary>
+        /// Moves an entity that is already in the grid
+        /// </summary>
+        void Update(ptr<IEntity> entity, IVector2 const& position);
+
+        /// <summary>
+        /// Removes an entity from the grid iff it is there
+        /// </summary>
+        void Remove(ptr<IEntity> entity);
+
+        bool Contains(ptr<IEntity> entity) const;
+        uint_ Size() const;
+        void Clear();
+
+        /// <summary>
+        /// Appends every entity exactly at a position to results
+        /// </summary>
+        void QueryPoint(IVector2 const& position, vec<ptr<IEntity>> & results) const;
+
+        /// <summary>
+        /// Appends every entity inside of a rectangle to results
+        /// </summary>
+        void QueryRect(IRect const& area, vec<ptr<IEntity>> & results) const;
+
+        /// <summary>
+        /// Appends every entity within a distance of a position to results
+        /// </summary>
+        void QueryRadius(IVector2 const& center, int_ radius, vec<ptr<IEntity>> & results) const;
+
+    private:
+        int_ cellCoord(int_ value) const;
+        static ui64 cellKey(int_ cell_x, int_ cell_y);
+        void link(ptr<IEntity> entity, Entry & entry);
+        void unlink(ptr<IEntity> entity, Entry const& entry);
+
+        template <class Predicate>
+        void query(int_ min_x, int_ min_y, int_ max_x, int_ max_y, Predicate const& predicate, vec<ptr<IEntity>> & results) const;
+    };
+
+    template <class Predicate>
+    inline void SpatialGrid::query(int_ min_x, int_ min_y, int_ max_x, int_ max_y, Predicate const& predicate, vec<ptr<IEntity>> & results) const {
+        if((min_x > max_x) || (min_y > max_y)) {
+            return;
+        }
+        for(int_ cy = cellCoord(min_y); cy <= cellCoord(max_y); ++cy) {
+            for(int_ cx = cellCoord(min_x); cx <= cellCoord(max_x); ++cx) {
+                auto cell = _cells.find(cellKey(cx, cy));
+                if(cell == std::end(_cells)) {
+                    continue;
+                }
+                for(auto const& occupant : cell->second) {
+                    if(predicate(occupant.Position)) {
+                        results.push_back(occupant.Entity);
+                    }
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "StringTable.hpp"
+
+namespace gquest {
+
+    uptr<StringTable> StringTable::_instance = nullptr;
+
+    StringTable::StringTable() : _mutex(), _symbols(), _strings() {
+        Intern(string());
+    }
+
+    symbol StringTable::Intern(string const & str) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _symbols.find(str);
+        if(iter != std::end(_symbols)) {
+            return iter->second;
+        }
+        auto sym = static_cast<symbol>(_strings.size());
+        auto inserted = _symbols.emplace(str, sym).first;
+        _strings.push_back(&inserted->first);
+        return sym;
+    }
+
+    symbol StringTable::Find(string const & str) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _symbols.find(str);
+        if(iter == std::end(_symbols)) {
+            return InvalidSymbol;
+        }
+        return iter->second;
+    }
+
+    string const & StringTable::Lookup(symbol sym) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return *_strings.at(sym);
+    }
+
+    uint_ StringTable::Size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _strings.size();
+    }
+
+    ptr<StringTable> StringTable::Get() {
+        if(_instance == nullptr) {
+            _instance = uptr<StringTable>(new StringTable());
+        }
+        return _instance.get();
+    }
+
+}
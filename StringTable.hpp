@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include "GalactiQuestBase.hpp"
+
+namespace gquest {
+
+    /// <summary>
+    /// A small id standing in for an interned string
+    /// </summary>
+    using symbol = ui32;
+
+    /// <summary>
+    /// The symbol of the empty string, which is always interned
+    /// </summary>
+    constexpr symbol EmptySymbol = 0;
+
+    /// <summary>
+    /// Returned by StringTable::Find for strings that have never been interned
+    /// </summary>
+    constexpr symbol InvalidSymbol = 0xFFFFFFFFu;
+
+    /// <summary>
+    /// Keeps one copy of every interned string and hands out a symbol for each
+    /// </summary>
+    /// <remarks>
+    /// Strings are never removed, so symbols and the references returned by
+    /// Lookup stay good for the life of the program. Interning and lookups
+    /// are thread-safe.
+    /// </remarks>
+    class StringTable {
+    private:
+        mutable std::mutex _mutex;
+
+        /// <summary>
+        /// Maps each string to its symbol; the keys are the only copies of the strings
+        /// </summary>
+        hashmap<string, symbol> _symbols;
+
+        /// <summary>
+        /// Points at the keys of _symbols by symbol, which stay put when the map rehashes
+        /// </summary>
+        vec<ptr<string const>> _strings;
+
+        static uptr<StringTable> _instance;
+
+    public:
+        StringTable();
+        StringTable(StringTable const&) = delete;
+        StringTable & operator =(StringTable const&) = delete;
+
+        /// <summary>
+        /// Returns the symbol of a string, interning it iff it has not been seen before
+        /// </summary>
+        symbol Intern(string const& str);
+
+        /// <summary>
+        /// Returns the symbol of a string, or InvalidSymbol iff it has never been interned
+        /// </summary>
+        symbol Find(string const& str) const;
+
+        /// <summary>
+        /// Returns the string behind a symbol, throwing std::out_of_range iff the symbol was not handed out
+        /// </summary>
+        string const& Lookup(symbol sym) const;
+
+        uint_ Size() const;
+
+        static ptr<StringTable> Get();
+    };
+
+}
@@ -0,0 +1,59 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Drew Wibbenmeyer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "stdafx.h"
+#include "Tests.hpp"
+
+// Engine tests. Runs every test, or only the ones whose name starts with
+// the argument, and returns non-zero iff any of them failed.
+//
+//   GalactiQuestTests.exe [name prefix]
+
+int wmain(int argc, wchar_t * argv[]) {
+    using namespace gquest;
+    using Test = std::pair<string, function<void()>>;
+    vec<Test> const all_tests = {
+        { L"CommandBatchKeepsControllerOrder", tests::CommandBatchKeepsControllerOrder },
+        { L"CommandQueueMatchesModel", tests::CommandQueueMatchesModel },
+        { L"CommandQueueHandles", tests::CommandQueueHandles },
+        { L"ReplayMatchesRecording", tests::ReplayMatchesRecording },
+        { L"SimulationSchedulerBuildsWaves", tests::SimulationSchedulerBuildsWaves },
+        { L"SimulationSchedulerRunsWaveConcurrently", tests::SimulationSchedulerRunsWaveConcurrently },
+    };
+    string prefix = (argc > 1) ? argv[1] : L"";
+    uint_ failed = 0;
+    uint_ run = 0;
+    for(auto const& test : all_tests) {
+        if(test.first.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        ++run;
+        try {
+            test.second();
+            std::wcout << L"PASS " << test.first << std::endl;
+        } catch(std::exception const& e) {
+            ++failed;
+            std::wcout << L"FAIL " << test.first << L": " << e.what() << std::endl;
+        }
+    }
+    std::wcout << (run - failed) << L"/" << run << L" tests passed" << std::endl;
+    return (failed == 0) ? 0 : 1;
+}
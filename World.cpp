@@ -21,81 +21,133 @@
 // SOFTWARE.
 #include "stdafx.h"
 #include "World.hpp"
+#include "Components.hpp"
+#include "ArchetypeEntity.hpp"
 
 namespace gquest {
 
-    World::World() {
-        _entities[0] = EntityList{ };
+    /// <summary>
+    /// Marks the World as being iterated for as long as it is alive
+    /// </summary>
+    class World::IterationScope {
+    private:
+        World & _world;
+    public:
+        IterationScope(World & world) : _world(world) {
+            ++_world._iterationDepth;
+        }
+        ~IterationScope() {
+            --_world._iterationDepth;
+            _world.FlushChanges();
+        }
+    };
+
+    World::World(ptr<EntityRegistry> registry) : _registry(registry), _iterationDepth(0), _parallel(false), _plainEntityCount(0), _dormancyEnabled(false), _lastTick(0) {
+        _entities[0] = EntityHandleList{ };
+        _onPositionChanged = PositionChangedEventHandlerPtr(
+            new PositionChangedEventHandler(
+                [this](ptr<IEntity> entity, IVector2 const& position) { onPositionChanged(entity, position); }
+            )
+        );
+        components::Position::AddPositionChangedHandler(_onPositionChanged);
+    }
+
+    World::~World() {
+        components::Position::RemovePositionChangedHandler(_onPositionChanged);
+    }
+
+    ptr<EntityRegistry> World::GetRegistry() const {
+        return _registry;
+    }
+
+    EntityPtr const & World::GetEntity(EntityHandle entity) const {
+        return _registry->ResolveShared(entity);
     }
 
     bool World::AddEntityToSystem(EntityPtr entity, sysid system_id) {
-        if(_entities.find(system_id) == std::end(_entities)) {
-            _entities[system_id] = EntityList{ };
+        if(entity == nullptr) {
+            return false;
         }
-        if(std::find(std::begin(_entities[system_id]), std::end(_entities[system_id]), entity) != std::end(_entities[system_id])) {
+        return AddEntityToSystem(_registry->Register(entity), system_id);
+    }
+
+    bool World::AddEntityToSystem(EntityHandle entity, sysid system_id) {
+        sysid current;
+        if(!_registry->IsAlive(entity) || locate(entity, current)) {
             return false;
         }
-        _entities[system_id].push_back(entity);
+        setLocation(entity, true, system_id);
         return true;
     }
 
     bool World::RemoveEntityFromSystem(EntityPtr entity, sysid system_id) {
-        auto iter = _entities.find(system_id);
-        if(iter == std::end(_entities)) {
-            return false;
-        }
-        auto ent_iter = std::find(std::begin(iter->second), std::end(iter->second), entity);
-        if(ent_iter == std::end(iter->second)) {
+        return RemoveEntityFromSystem(handleOf(entity), system_id);
+    }
+
+    bool World::RemoveEntityFromSystem(EntityHandle entity, sysid system_id) {
+        sysid current;
+        if(!locate(entity, current) || (current != system_id)) {
             return false;
         }
-        _entities[system_id].erase(ent_iter);
+        setLocation(entity, false, NoSystem);
         return true;
     }
 
     bool World::RemoveEntity(EntityPtr entity) {
-        for(auto & system : _entities) {
-            auto ent_iter = std::find(std::begin(system.second), std::end(system.second), entity);
-            if(ent_iter != std::end(system.second)) {
-                system.second.erase(ent_iter);
-                return true;
-            }
+        return RemoveEntity(handleOf(entity));
+    }
+
+    bool World::RemoveEntity(EntityHandle entity) {
+        sysid current;
+        if(!locate(entity, current)) {
+            return false;
         }
-        return false;
+        setLocation(entity, false, NoSystem);
+        return true;
     }
 
     bool World::MoveEntity(EntityPtr entity, sysid system_id) {
-        if(RemoveEntity(entity)) {
-            return AddEntityToSystem(entity, system_id);
+        return MoveEntity(handleOf(entity), system_id);
+    }
+
+    bool World::MoveEntity(EntityHandle entity, sysid system_id) {
+        sysid current;
+        if(!locate(entity, current)) {
+            return false;
+        }
+        if(current != system_id) {
+            setLocation(entity, true, system_id);
         }
-        return false;
+        return true;
     }
 
     bool World::MoveEntityFrom(EntityPtr entity, sysid current_system, sysid dest_system) {
-        if(RemoveEntityFromSystem(entity, current_system)) {
-            return AddEntityToSystem(entity, dest_system);
+        return MoveEntityFrom(handleOf(entity), current_system, dest_system);
+    }
+
+    bool World::MoveEntityFrom(EntityHandle entity, sysid current_system, sysid dest_system) {
+        sysid current;
+        if(!locate(entity, current) || (current != current_system)) {
+            return false;
         }
-        return false;
+        if(current != dest_system) {
+            setLocation(entity, true, dest_system);
+        }
+        return true;
     }
 
     void World::RunOnEntityInSystem(EntityPtr entity, EntityCallback const & callback, sysid system_id) {
-        auto iter = _entities.find(system_id);
-        if(iter == std::end(_entities)) {
-            return;
-        }
-        auto ent_iter = std::find(std::begin(iter->second), std::end(iter->second), entity);
-        if(ent_iter == std::end(iter->second)) {
-            return;
+        if(IsEntityInSystem(entity, system_id)) {
+            IterationScope scope(*this);
+            callback(entity, system_id);
         }
-        callback(entity, system_id);
     }
 
     void World::RunOnEntity(EntityPtr entity, EntityCallback const & callback) {
-        for(auto & system : _entities) {
-            auto ent_iter = std::find(std::begin(system.second), std::end(system.second), entity);
-            if(ent_iter != std::end(system.second)) {
-                callback(entity, system.first);
-                return;
-            }
+        sysid system_id;
+        if(locate(handleOf(entity), system_id)) {
+            IterationScope scope(*this);
+            callback(entity, system_id);
         }
     }
 
@@ -104,87 +156,497 @@ namespace gquest {
         if(iter == std::end(_entities)) {
             return;
         }
-        for(auto & entity : iter->second) {
-            callback(entity, system_id);
-        }
+        IterationScope scope(*this);
+        runOnList(iter->second, system_id, callback);
     }
 
     void World::RunOnEntities(EntityCallback const & callback) {
+        IterationScope scope(*this);
         for(auto & system : _entities) {
-            for(auto & entity : system.second) {
-                callback(entity, system.first);
-            }
+            runOnList(system.second, system.first, callback);
         }
     }
 
-    void World::RunOnValidEntityInSystem(EntityPtr entity, EntityPredicate const & predicate, EntityCallback const & callback, sysid system_id) {
+    void World::RunOnEntitiesInSystemWith(ComponentMask const & required, EntityCallback const & callback, sysid system_id) {
         auto iter = _entities.find(system_id);
         if(iter == std::end(_entities)) {
             return;
         }
-        auto ent_iter = std::find(std::begin(iter->second), std::end(iter->second), entity);
-        if(ent_iter == std::end(iter->second)) {
+        IterationScope scope(*this);
+        EntityHandleList matches;
+        if(collectFromArchetypes(required, system_id, false, iter->second.size(), matches)) {
+            runOnList(matches, system_id, callback);
+        } else {
+            runOnList(iter->second, system_id, callback, required);
+        }
+    }
+
+    void World::RunOnEntitiesWith(ComponentMask const & required, EntityCallback const & callback) {
+        IterationScope scope(*this);
+        uint_ total = 0;
+        for(auto const& system : _entities) {
+            total += system.second.size();
+        }
+        EntityHandleList matches;
+        if(collectFromArchetypes(required, NoSystem, true, total, matches)) {
+            for(auto entity : matches) {
+                auto const& resolved = _registry->ResolveShared(entity);
+                if(resolved != nullptr) {
+                    callback(resolved, _locations[entity.GetIndex()].System);
+                }
+            }
             return;
         }
-        if(predicate(entity, system_id)) {
-            callback(entity, system_id);
+        for(auto & system : _entities) {
+            runOnList(system.second, system.first, callback, required);
         }
     }
 
-    void World::RunOnValidEntity(EntityPtr entity, EntityPredicate const & predicate, EntityCallback const & callback) {
+    void World::ParallelRunOnEntities(EntityCallback const & callback, JobPool & pool) {
+        IterationScope scope(*this);
+        vec<std::pair<sysid, ptr<EntityHandleList>>> systems;
         for(auto & system : _entities) {
-            auto ent_iter = std::find(std::begin(system.second), std::end(system.second), entity);
-            if(ent_iter != std::end(system.second)) {
-                if(predicate(entity, system.first)) {
-                    callback(entity, system.first);
-                }
-                return;
+            if(!system.second.empty()) {
+                systems.push_back(std::make_pair(system.first, &system.second));
             }
         }
+        std::stable_sort(std::begin(systems), std::end(systems),
+            [](std::pair<sysid, ptr<EntityHandleList>> const& lhs, std::pair<sysid, ptr<EntityHandleList>> const& rhs) {
+                return lhs.second->size() > rhs.second->size();
+            }
+        );
+
+        vec<JobPool::Job> jobs;
+        jobs.reserve(systems.size());
+        for(auto const& system : systems) {
+            jobs.push_back([this, &callback, system]() {
+                runOnList(*system.second, system.first, callback);
+            });
+        }
+        RunJobsInParallel(jobs, pool);
     }
 
-    void World::RunOnValidEntitiesInSystem(EntityPredicate const & predicate, EntityCallback const & callback, sysid system_id) {
-        auto iter = _entities.find(system_id);
-        if(iter == std::end(_entities)) {
+    void World::RunJobsInParallel(vec<JobPool::Job> const & jobs, JobPool & pool) {
+        IterationScope scope(*this);
+        if(_parallel) {
+            // Already inside a parallel section, so the pool runs this batch serially
+            pool.Run(jobs);
             return;
         }
-        for(auto & entity : iter->second) {
+        _parallel = true;
+        try {
+            pool.Run(jobs);
+        } catch(...) {
+            _parallel = false;
+            throw;
+        }
+        _parallel = false;
+    }
+
+    void World::RunOnActiveEntities(EntityCallback const & callback, uint_ now, ComponentMask const & required) {
+        IterationScope scope(*this);
+        catchUpWaking(now);
+        for(auto & system : _entities) {
+            if(IsSystemDormant(system.first)) {
+                continue;
+            }
+            activity(system.first).LastSimulated = now;
+            runOnList(system.second, system.first, callback, required);
+        }
+    }
+
+    void World::AdvanceActiveSystems(uint_ now) {
+        IterationScope scope(*this);
+        catchUpWaking(now);
+        for(auto & system : _entities) {
+            if(!IsSystemDormant(system.first)) {
+                activity(system.first).LastSimulated = now;
+            }
+        }
+    }
+
+    void World::RunOnValidEntityInSystem(EntityPtr entity, EntityPredicate const & predicate, EntityCallback const & callback, sysid system_id) {
+        if(IsEntityInSystem(entity, system_id)) {
+            IterationScope scope(*this);
             if(predicate(entity, system_id)) {
                 callback(entity, system_id);
             }
         }
     }
 
+    void World::RunOnValidEntity(EntityPtr entity, EntityPredicate const & predicate, EntityCallback const & callback) {
+        sysid system_id;
+        if(locate(handleOf(entity), system_id)) {
+            IterationScope scope(*this);
+            if(predicate(entity, system_id)) {
+                callback(entity, system_id);
+            }
+        }
+    }
+
+    void World::RunOnValidEntitiesInSystem(EntityPredicate const & predicate, EntityCallback const & callback, sysid system_id) {
+        auto iter = _entities.find(system_id);
+        if(iter == std::end(_entities)) {
+            return;
+        }
+        IterationScope scope(*this);
+        runOnList(iter->second, system_id, [&predicate, &callback](EntityPtr const& entity, sysid system) {
+            if(predicate(entity, system)) {
+                callback(entity, system);
+            }
+        });
+    }
+
     void World::RunOnValidEntities(EntityPredicate const & predicate, EntityCallback const & callback) {
+        IterationScope scope(*this);
         for(auto & system : _entities) {
-            for(auto & entity : system.second) {
-                if(predicate(entity, system.first)) {
-                    callback(entity, system.first);
+            runOnList(system.second, system.first, [&predicate, &callback](EntityPtr const& entity, sysid system) {
+                if(predicate(entity, system)) {
+                    callback(entity, system);
                 }
-            }
+            });
         }
     }
 
     bool World::IsEntityInSystem(EntityPtr entity, sysid system_id) {
-        auto iter = _entities.find(system_id);
-        if(iter == std::end(_entities)) {
+        return IsEntityInSystem(handleOf(entity), system_id);
+    }
+
+    bool World::IsEntityInSystem(EntityHandle entity, sysid system_id) {
+        sysid current;
+        return locate(entity, current) && (current == system_id);
+    }
+
+    bool World::DoesEntityExist(EntityPtr entity) {
+        return DoesEntityExist(handleOf(entity));
+    }
+
+    bool World::DoesEntityExist(EntityHandle entity) {
+        sysid current;
+        return locate(entity, current);
+    }
+
+    bool World::IsEntityActive(EntityHandle entity) const {
+        sysid current;
+        return locate(entity, current) && !IsSystemDormant(current);
+    }
+
+    bool World::IsIterating() const {
+        return _iterationDepth > 0;
+    }
+
+    void World::QueryEntitiesAt(IVector2 const & position, vec<ptr<IEntity>> & results, sysid system_id) const {
+        auto iter = _grids.find(system_id);
+        if(iter != std::end(_grids)) {
+            iter->second.QueryPoint(position, results);
+        }
+    }
+
+    void World::QueryEntitiesInRect(IRect const & area, vec<ptr<IEntity>> & results, sysid system_id) const {
+        auto iter = _grids.find(system_id);
+        if(iter != std::end(_grids)) {
+            iter->second.QueryRect(area, results);
+        }
+    }
+
+    void World::QueryEntitiesInRadius(IVector2 const & center, int_ radius, vec<ptr<IEntity>> & results, sysid system_id) const {
+        auto iter = _grids.find(system_id);
+        if(iter != std::end(_grids)) {
+            iter->second.QueryRadius(center, radius, results);
+        }
+    }
+
+    void World::SetDormancyEnabled(bool enabled) {
+        _dormancyEnabled = enabled;
+    }
+
+    bool World::IsDormancyEnabled() const {
+        return _dormancyEnabled;
+    }
+
+    void World::SetObserver(EntityPtr entity, bool is_observer) {
+        auto handle = handleOf(entity);
+        if(is_observer && !handle.IsValid()) {
+            handle = _registry->Register(entity);
+        }
+        SetObserver(handle, is_observer);
+    }
+
+    void World::SetObserver(EntityHandle entity, bool is_observer) {
+        if(is_observer && !_registry->IsAlive(entity)) {
+            return;
+        }
+        auto found = _observers.find(entity);
+        if(is_observer == (found != std::end(_observers))) {
+            return;
+        }
+        auto location = findLocation(entity);
+        if(is_observer) {
+            _observers.insert(entity);
+            if(location != nullptr) {
+                observerEntered(location->System);
+            }
+        } else {
+            _observers.erase(found);
+            if(location != nullptr) {
+                observerLeft(location->System);
+            }
+        }
+    }
+
+    bool World::IsObserver(EntityPtr entity) const {
+        return IsObserver(handleOf(entity));
+    }
+
+    bool World::IsObserver(EntityHandle entity) const {
+        return _observers.find(entity) != std::end(_observers);
+    }
+
+    bool World::IsSystemDormant(sysid system_id) const {
+        if(!_dormancyEnabled) {
             return false;
         }
-        auto ent_iter = std::find(std::begin(iter->second), std::end(iter->second), entity);
-        if(ent_iter == std::end(iter->second)) {
+        auto iter = _activity.find(system_id);
+        return (iter == std::end(_activity)) || (iter->second.Observers == 0);
+    }
+
+    uint_ World::GetLastSimulated(sysid system_id) const {
+        auto iter = _activity.find(system_id);
+        if(iter == std::end(_activity)) {
+            return _lastTick;
+        }
+        return iter->second.LastSimulated;
+    }
+
+    void World::SetCatchUpCallback(SystemCatchUpCallback const & callback) {
+        _catchUp = callback;
+    }
+
+    void World::FlushChanges() {
+        if(IsIterating()) {
+            return;
+        }
+        for(auto & change : _pending) {
+            applyLocation(change.Entity, change.Exists, change.System);
+        }
+        _pending.clear();
+        _pendingIndex.clear();
+    }
+
+    EntityHandle World::handleOf(EntityPtr const& entity) {
+        if(entity == nullptr) {
+            return InvalidEntity;
+        }
+        return entity->GetHandle();
+    }
+
+    World::EntityLocation const* World::findLocation(EntityHandle entity) const {
+        auto index = entity.GetIndex();
+        if(index >= _locations.size()) {
+            return nullptr;
+        }
+        auto const& location = _locations[index];
+        if(!location.Present || (location.Generation != entity.GetGeneration())) {
+            return nullptr;
+        }
+        return &location;
+    }
+
+    bool World::locate(EntityHandle entity, sysid & system_id) const {
+        std::unique_lock<std::mutex> lock(_pendingMutex, std::defer_lock);
+        if(_parallel) {
+            lock.lock();
+        }
+        auto pending = _pendingIndex.find(entity);
+        if(pending != std::end(_pendingIndex)) {
+            auto const& change = _pending[pending->second];
+            system_id = change.System;
+            return change.Exists;
+        }
+        auto location = findLocation(entity);
+        if(location == nullptr) {
             return false;
         }
+        system_id = location->System;
         return true;
     }
 
-    bool World::DoesEntityExist(EntityPtr entity) {
-        for(auto const& system : _entities) {
-            auto ent_iter = std::find(std::begin(system.second), std::end(system.second), entity);
-            if(ent_iter != std::end(system.second)) {
-                return true;
+    void World::setLocation(EntityHandle entity, bool exists, sysid system_id) {
+        if(!IsIterating()) {
+            applyLocation(entity, exists, system_id);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_pendingMutex, std::defer_lock);
+        if(_parallel) {
+            lock.lock();
+        }
+        auto pending = _pendingIndex.find(entity);
+        if(pending != std::end(_pendingIndex)) {
+            auto & change = _pending[pending->second];
+            change.Exists = exists;
+            change.System = system_id;
+            return;
+        }
+        _pendingIndex[entity] = _pending.size();
+        _pending.push_back(PendingChange{entity, exists, system_id});
+    }
+
+    void World::applyLocation(EntityHandle entity, bool exists, sysid system_id) {
+        auto location = findLocation(entity);
+        if(location != nullptr) {
+            if(exists && (location->System == system_id)) {
+                return;
+            }
+            detach(entity, *location);
+        }
+        if(exists) {
+            if(_registry->IsAlive(entity)) {
+                attach(entity, system_id);
+            }
+        } else {
+            _observers.erase(entity);
+        }
+    }
+
+    void World::attach(EntityHandle entity, sysid system_id) {
+        auto & list = _entities[system_id];
+        auto index = entity.GetIndex();
+        if(index >= _locations.size()) {
+            _locations.resize(index + 1, EntityLocation{NoSystem, 0, 0, false, nullptr, false});
+        }
+        auto resolved = _registry->Resolve(entity);
+        auto plain = dynamic_cast<ptr<ArchetypeEntity>>(resolved) == nullptr;
+        _locations[index] = EntityLocation{system_id, list.size(), entity.GetGeneration(), true, resolved, plain};
+        list.push_back(entity);
+        activity(system_id);
+        if(_observers.find(entity) != std::end(_observers)) {
+            observerEntered(system_id);
+        }
+        auto pos = resolved->TryGet<components::Position>();
+        if(pos != nullptr) {
+            _grids[system_id].Insert(resolved, pos->GetPosition());
+        }
+        if(plain) {
+            ++_plainEntities[system_id];
+            ++_plainEntityCount;
+        }
+    }
+
+    void World::detach(EntityHandle entity, EntityLocation location) {
+        auto & list = _entities[location.System];
+        if(location.Slot + 1 != list.size()) {
+            list[location.Slot] = list.back();
+            _locations[list[location.Slot].GetIndex()].Slot = location.Slot;
+        }
+        list.pop_back();
+        _locations[entity.GetIndex()].Present = false;
+        _locations[entity.GetIndex()].Entity = nullptr;
+        if(_observers.find(entity) != std::end(_observers)) {
+            observerLeft(location.System);
+        }
+        auto grid = _grids.find(location.System);
+        if(grid != std::end(_grids)) {
+            grid->second.Remove(location.Entity);
+        }
+        if(location.Plain) {
+            --_plainEntities[location.System];
+            --_plainEntityCount;
+        }
+    }
+
+    void World::runOnList(EntityHandleList const& list, sysid system_id, EntityCallback const& callback, ComponentMask const& required) const {
+        for(auto entity : list) {
+            auto const& resolved = _registry->ResolveShared(entity);
+            if((resolved != nullptr) && resolved->HasComponents(required)) {
+                callback(resolved, system_id);
             }
         }
-        return false;
+    }
+
+    bool World::collectFromArchetypes(ComponentMask const& required, sysid system_id, bool any_system, uint_ limit, EntityHandleList & matches) const {
+        if(required.none()) {
+            return false;
+        }
+        if(any_system) {
+            if(_plainEntityCount > 0) {
+                return false;
+            }
+        } else {
+            auto plain = _plainEntities.find(system_id);
+            if((plain != std::end(_plainEntities)) && (plain->second > 0)) {
+                return false;
+            }
+        }
+        auto storage = ArchetypeStorage::Get();
+        uint_ rows = 0;
+        storage->ForEachArchetypeWith(required, [&rows](Archetype & archetype) { rows += archetype.Size(); });
+        if(rows >= limit) {
+            return false;
+        }
+        // The storage holds the entities of every World, so a row only counts if this World has that very entity
+        matches.reserve(rows);
+        storage->ForEachArchetypeWith(required, [&](Archetype & archetype) {
+            for(uint_ row = 0; row < archetype.Size(); ++row) {
+                auto entity = archetype.GetEntity(row);
+                auto location = findLocation(entity->GetHandle());
+                if((location != nullptr) && (location->Entity == entity) && (any_system || (location->System == system_id))) {
+                    matches.push_back(entity->GetHandle());
+                }
+            }
+        });
+        return true;
+    }
+
+    void World::catchUpWaking(uint_ now) {
+        _lastTick = now;
+        auto waking = std::move(_waking);
+        _waking.clear();
+        for(auto system_id : waking) {
+            auto & state = activity(system_id);
+            if(!IsSystemDormant(system_id) && (state.LastSimulated < now)) {
+                if(_catchUp) {
+                    _catchUp(system_id, state.LastSimulated, now);
+                }
+                state.LastSimulated = now;
+            }
+        }
+    }
+
+    World::SystemActivity & World::activity(sysid system_id) {
+        auto iter = _activity.find(system_id);
+        if(iter == std::end(_activity)) {
+            iter = _activity.insert(std::make_pair(system_id, SystemActivity{0, _lastTick})).first;
+        }
+        return iter->second;
+    }
+
+    void World::observerEntered(sysid system_id) {
+        auto & state = activity(system_id);
+        if((state.Observers++ == 0) && _dormancyEnabled) {
+            if(std::find(std::begin(_waking), std::end(_waking), system_id) == std::end(_waking)) {
+                _waking.push_back(system_id);
+            }
+        }
+    }
+
+    void World::observerLeft(sysid system_id) {
+        auto & state = activity(system_id);
+        if(state.Observers > 0) {
+            --state.Observers;
+        }
+    }
+
+    void World::onPositionChanged(ptr<IEntity> entity, IVector2 const & position) {
+        // Every World hears about every Position, and a World with its own
+        // registry can hold a different entity under the same handle
+        auto location = findLocation(entity->GetHandle());
+        if((location == nullptr) || (location->Entity != entity)) {
+            return;
+        }
+        auto grid = _grids.find(location->System);
+        if(grid != std::end(_grids)) {
+            grid->second.Update(entity, position);
+        }
     }
 
 }
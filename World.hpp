@@ -23,13 +23,40 @@
 
 #include "GalactiQuestBase.hpp"
 #include "IEntity.hpp"
+#include "EntityHandle.hpp"
+#include "EntityRegistry.hpp"
+#include "JobPool.hpp"
+#include "SpatialGrid.hpp"
+#include "EventHandler.hpp"
 
 namespace gquest {
 
     class World {
     private:
         /// <summary>
-        /// Holds a mapping of sysids to lists of entities
+        /// Where an entity currently lives inside of the World
+        /// </summary>
+        /// <remarks>
+        /// The raw entity pointer is kept so the entity can still be taken
+        /// out of the SpatialGrid after its handle has been released. Plain
+        /// is set for entities that are not kept in the ArchetypeStorage.
+        /// </remarks>
+        struct EntityLocation {
+            sysid System;
+            uint_ Slot;
+            ui32 Generation;
+            bool Present;
+            ptr<IEntity> Entity;
+            bool Plain;
+        };
+
+        /// <summary>
+        /// The registry that owns the entities whose handles are stored in the World
+        /// </summary>
+        ptr<EntityRegistry> _registry;
+
+        /// <summary>
+        /// Holds a mapping of sysids to lists of entity handles
         /// </summary>
         /// <remarks>
         /// The sysids correspond to the Systems that the entities are
@@ -38,39 +65,153 @@ namespace gquest {
         /// A sysid of 0 indicates that the entity is currently at galactic
         /// level.
         /// </remarks>
-        EntityMap _entities;
+        EntityHandleMap _entities;
+
+        /// <summary>
+        /// Holds the system and slot within that system's list of every entity in the World, indexed by handle index
+        /// </summary>
+        /// <remarks>
+        /// This is what keeps lookups, moves, and removals constant time
+        /// rather than a scan over every list. An entity can only be in one
+        /// place at a time, so removals swap the last handle of the list into
+        /// the freed slot, which means the order of a list is not stable.
+        /// </remarks>
+        vec<EntityLocation> _locations;
+
+        /// <summary>
+        /// A change to where an entity lives that is waiting to be applied
+        /// </summary>
+        struct PendingChange {
+            EntityHandle Entity;
+            bool Exists;
+            sysid System;
+        };
+
+        /// <summary>
+        /// Holds changes made to the World while its entity lists are being iterated
+        /// </summary>
+        /// <remarks>
+        /// Only the final state of each entity is recorded, so an add followed
+        /// by a remove cancels out and several moves collapse into one. The
+        /// changes are applied in the order the entities were first touched.
+        /// </remarks>
+        vec<PendingChange> _pending;
+        hashmap<EntityHandle, uint_> _pendingIndex;
+        std::atomic<uint_> _iterationDepth;
+
+        /// <summary>
+        /// Guards the pending changes while ParallelRunOnEntities is running
+        /// </summary>
+        mutable std::mutex _pendingMutex;
+        bool _parallel;
+
+        /// <summary>
+        /// Holds a SpatialGrid of every entity with a Position for each system
+        /// </summary>
+        /// <remarks>
+        /// Entities are put into the grid when they are added to the World
+        /// and kept up to date through Position's changed handlers.
+        /// </remarks>
+        map<sysid, SpatialGrid> _grids;
+        PositionChangedEventHandlerPtr _onPositionChanged;
+
+        /// <summary>
+        /// Holds how many entities in each system are not kept in the ArchetypeStorage, and how many there are in all
+        /// </summary>
+        /// <remarks>
+        /// Queries for components can only walk the archetypes instead of a
+        /// system's list when there are none, or they would miss them.
+        /// </remarks>
+        map<sysid, uint_> _plainEntities;
+        uint_ _plainEntityCount;
+
     public:
-        World();
+        /// <remarks>
+        /// Callbacks are handed a reference into the EntityRegistry, so no
+        /// reference counts are touched while iterating.
+        /// </remarks>
+        using EntityCallback = std::function<void(EntityPtr const&, sysid)>;
+        using EntityPredicate = std::function<bool(EntityPtr const&, sysid)>;
+        using SystemCatchUpCallback = std::function<void(sysid, uint_, uint_)>;
+
+    private:
+        /// <summary>
+        /// Keeps track of whether a system is being simulated
+        /// </summary>
+        struct SystemActivity {
+            uint_ Observers;
+            uint_ LastSimulated;
+        };
+
+        /// <summary>
+        /// Holds the activity of every system that has ever had an entity in it
+        /// </summary>
+        /// <remarks>
+        /// When dormancy is enabled, a system without any observers in it is
+        /// dormant: RunOnActiveEntities skips it and its LastSimulated time
+        /// stops advancing. Once an observer enters it again, the catch-up
+        /// callback is given the time it was last simulated and the current
+        /// time so it can fast-forward the system up to, but not including,
+        /// the current time before it is ticked as usual.
+        ///
+        /// Removing an entity from the World also clears its observer flag.
+        /// </remarks>
+        map<sysid, SystemActivity> _activity;
+        hashset<EntityHandle> _observers;
+        vec<sysid> _waking;
+        bool _dormancyEnabled;
+        uint_ _lastTick;
+        SystemCatchUpCallback _catchUp;
+    public:
+        World(ptr<EntityRegistry> registry = EntityRegistry::Get());
+        World(World const&) = delete;
+        World & operator =(World const&) = delete;
+        ~World();
 
         static constexpr sysid NoSystem = 0;
 
         /// <summary>
-        /// Adds an Entity to the specific system or the galaxy
+        /// Returns the registry that owns the entities in the World
+        /// </summary>
+        ptr<EntityRegistry> GetRegistry() const;
+
+        /// <summary>
+        /// Returns the entity a handle refers to, or an empty pointer iff the handle is stale
         /// </summary>
+        EntityPtr const& GetEntity(EntityHandle entity) const;
+
+        /// <summary>
+        /// Adds an Entity to the specific system or the galaxy iff it is not already somewhere in the World
+        /// </summary>
+        /// <remarks>
+        /// The entity is registered with the World's EntityRegistry first iff it is not already.
+        /// </remarks>
         bool AddEntityToSystem(EntityPtr entity, sysid system_id = NoSystem);
+        bool AddEntityToSystem(EntityHandle entity, sysid system_id = NoSystem);
 
         /// <summary>
         /// Removes an Entity from a system or the galaxy iff it is there
         /// </summary>
         bool RemoveEntityFromSystem(EntityPtr entity, sysid system_id = NoSystem);
+        bool RemoveEntityFromSystem(EntityHandle entity, sysid system_id = NoSystem);
 
         /// <summary>
         /// Removes an Entity from the game world iff it exists
         /// </summary>
         bool RemoveEntity(EntityPtr entity);
+        bool RemoveEntity(EntityHandle entity);
 
         /// <summary>
         /// Moves an Entity to a system or the galaxy
         /// </summary>
         bool MoveEntity(EntityPtr entity, sysid system_id = NoSystem);
+        bool MoveEntity(EntityHandle entity, sysid system_id = NoSystem);
 
         /// <summary>
         /// Moves an Entity to a system or the galaxy iff it is in the specified current system or galaxy
         /// </summary>
         bool MoveEntityFrom(EntityPtr entity, sysid current_system = NoSystem, sysid dest_system = NoSystem);
-
-        using EntityCallback = std::function<void(EntityPtr, sysid)>;
-        using EntityPredicate = std::function<bool(EntityPtr, sysid)>;
+        bool MoveEntityFrom(EntityHandle entity, sysid current_system = NoSystem, sysid dest_system = NoSystem);
 
         /// <summary>
         /// Run a callback on the entity in a particular system or the galaxy iff it is found there
@@ -92,6 +233,95 @@ namespace gquest {
         /// </summary>
         void RunOnEntities(EntityCallback const& callback);
 
+        /// <summary>
+        /// Run a callback on all the entities in the system or the galaxy that have every component in a mask
+        /// </summary>
+        /// <remarks>
+        /// Whichever is smaller of the system's list and the rows of the
+        /// archetypes with every component in the mask is walked, and
+        /// filtered by the other, so a rare combination of components does
+        /// not cost a pass over every entity in the system.
+        /// </remarks>
+        void RunOnEntitiesInSystemWith(ComponentMask const& required, EntityCallback const& callback, sysid system_id = NoSystem);
+
+        /// <summary>
+        /// Run a callback on all entities in the game world that have every component in a mask
+        /// </summary>
+        /// <remarks>
+        /// Each entity is checked with a single AND of its signature, so
+        /// build the mask once with MaskOf rather than on every call. As
+        /// with RunOnEntitiesInSystemWith, the matching archetypes are walked
+        /// instead when they have fewer rows than the World has entities.
+        /// </remarks>
+        void RunOnEntitiesWith(ComponentMask const& required, EntityCallback const& callback);
+
+        /// <summary>
+        /// Run a callback on every entity in the game world that has all of the listed components, passing them in by reference
+        /// </summary>
+        /// <remarks>
+        /// The callback is called as callback(EntityPtr const&amp;, ComponentTypes&amp;...).
+        /// The mask is worked out once per list of types, and the components
+        /// come from the entity's slot cache rather than GetComponent.
+        /// </remarks>
+        template <class ...ComponentTypes, class Callback>
+        void ForEach(Callback const& callback);
+
+        /// <summary>
+        /// Run a callback on every entity in the system or the galaxy that has all of the listed components, passing them in by reference
+        /// </summary>
+        template <class ...ComponentTypes, class Callback>
+        void ForEachInSystem(Callback const& callback, sysid system_id = NoSystem);
+
+        /// <summary>
+        /// Run a callback on all entities in the game world, spreading the systems across a JobPool
+        /// </summary>
+        /// <remarks>
+        /// Every system is handled as a single job, so entities within one
+        /// system are still visited in order on one thread while different
+        /// systems run at the same time. Larger systems are handed out
+        /// first, and idle threads steal whatever is left.
+        ///
+        /// The callback may freely use the entity it was given, its
+        /// components, and other entities in the same system. It may also
+        /// add, remove, and move entities that are already registered, which
+        /// is deferred as usual and safe to do from any thread, but it must
+        /// not register new entities. It must not touch entities in other
+        /// systems, nor shared state such as Game::GetRandom(), without
+        /// synchronizing that access itself.
+        /// </remarks>
+        void ParallelRunOnEntities(EntityCallback const& callback, JobPool & pool = *JobPool::Get());
+
+        /// <summary>
+        /// Runs a batch of jobs on a JobPool as one parallel section of the World
+        /// </summary>
+        /// <remarks>
+        /// The jobs may add, remove, and move registered entities the same
+        /// way a ParallelRunOnEntities callback can, and every change is
+        /// applied once the whole batch has finished. It is up to the caller
+        /// to make sure the jobs do not touch the same components.
+        /// </remarks>
+        void RunJobsInParallel(vec<JobPool::Job> const& jobs, JobPool & pool = *JobPool::Get());
+
+        /// <summary>
+        /// Run a callback on all entities in systems that are not dormant, and mark those systems as simulated at now
+        /// </summary>
+        /// <remarks>
+        /// Systems that have woken up since the last call are caught up
+        /// first, before any callback is run. Only entities that have every
+        /// component in required are passed to the callback.
+        /// </remarks>
+        void RunOnActiveEntities(EntityCallback const& callback, uint_ now, ComponentMask const& required = ComponentMask());
+
+        /// <summary>
+        /// Does the dormancy bookkeeping of RunOnActiveEntities without visiting any entities
+        /// </summary>
+        /// <remarks>
+        /// Catches up the systems that have woken up and marks every system
+        /// that is awake as simulated at now. For systems that find their
+        /// work some other way, such as through the CommandScheduler.
+        /// </remarks>
+        void AdvanceActiveSystems(uint_ now);
+
         /// <summary>
         /// Run a callback on the entity in the system or the galaxy iff it is found and iff the predicate returns true
         /// </summary>
@@ -116,11 +346,112 @@ namespace gquest {
         /// Returns true iff the Entity is in the indicated system or at the galaxy level
         /// </summary>
         bool IsEntityInSystem(EntityPtr entity, sysid system_id = NoSystem);
+        bool IsEntityInSystem(EntityHandle entity, sysid system_id = NoSystem);
 
         /// <summary>
         /// Returns true iff the Entity exists anywhere in the galaxy
         /// </summary>
         bool DoesEntityExist(EntityPtr entity);
+        bool DoesEntityExist(EntityHandle entity);
+
+        /// <summary>
+        /// Returns true iff the Entity exists in the game world and its system or the galaxy is not dormant
+        /// </summary>
+        bool IsEntityActive(EntityHandle entity) const;
+
+        /// <summary>
+        /// Returns true iff the World's entity lists are currently being iterated
+        /// </summary>
+        /// <remarks>
+        /// While iterating, adding, removing, and moving entities is deferred
+        /// until the outermost iteration finishes. Those calls return what
+        /// they would have returned had they been applied immediately, and
+        /// IsEntityInSystem and DoesEntityExist already reflect them.
+        /// </remarks>
+        bool IsIterating() const;
+
+        /// <summary>
+        /// Appends every entity in the system or the galaxy that is exactly at a position to results
+        /// </summary>
+        void QueryEntitiesAt(IVector2 const& position, vec<ptr<IEntity>> & results, sysid system_id = NoSystem) const;
+
+        /// <summary>
+        /// Appends every entity in the system or the galaxy that is inside of an area to results
+        /// </summary>
+        void QueryEntitiesInRect(IRect const& area, vec<ptr<IEntity>> & results, sysid system_id = NoSystem) const;
+
+        /// <summary>
+        /// Appends every entity in the system or the galaxy that is within a distance of a position to results
+        /// </summary>
+        void QueryEntitiesInRadius(IVector2 const& center, int_ radius, vec<ptr<IEntity>> & results, sysid system_id = NoSystem) const;
+
+        /// <summary>
+        /// Turns letting systems without observers go dormant on or off
+        /// </summary>
+        void SetDormancyEnabled(bool enabled);
+        bool IsDormancyEnabled() const;
+
+        /// <summary>
+        /// Marks an Entity as keeping whatever system it is in awake, or not
+        /// </summary>
+        void SetObserver(EntityPtr entity, bool is_observer = true);
+        void SetObserver(EntityHandle entity, bool is_observer = true);
+        bool IsObserver(EntityPtr entity) const;
+        bool IsObserver(EntityHandle entity) const;
+
+        /// <summary>
+        /// Returns true iff the system or the galaxy is not currently being simulated
+        /// </summary>
+        bool IsSystemDormant(sysid system_id = NoSystem) const;
+
+        /// <summary>
+        /// Returns the last time passed to RunOnActiveEntities while the system or the galaxy was awake
+        /// </summary>
+        uint_ GetLastSimulated(sysid system_id = NoSystem) const;
+
+        /// <summary>
+        /// Sets the callback used to fast-forward a system from the time it went dormant to the time it woke up
+        /// </summary>
+        void SetCatchUpCallback(SystemCatchUpCallback const& callback);
+
+        /// <summary>
+        /// Applies all the deferred changes iff the World is not being iterated
+        /// </summary>
+        void FlushChanges();
+
+    private:
+        class IterationScope;
+
+        static EntityHandle handleOf(EntityPtr const& entity);
+        EntityLocation const* findLocation(EntityHandle entity) const;
+        bool locate(EntityHandle entity, sysid & system_id) const;
+        void setLocation(EntityHandle entity, bool exists, sysid system_id);
+        void applyLocation(EntityHandle entity, bool exists, sysid system_id);
+        void attach(EntityHandle entity, sysid system_id);
+        void detach(EntityHandle entity, EntityLocation location);
+        void runOnList(EntityHandleList const& list, sysid system_id, EntityCallback const& callback, ComponentMask const& required = ComponentMask()) const;
+        bool collectFromArchetypes(ComponentMask const& required, sysid system_id, bool any_system, uint_ limit, EntityHandleList & matches) const;
+        void onPositionChanged(ptr<IEntity> entity, IVector2 const& position);
+        void catchUpWaking(uint_ now);
+        SystemActivity & activity(sysid system_id);
+        void observerEntered(sysid system_id);
+        void observerLeft(sysid system_id);
     };
 
+    template <class ...ComponentTypes, class Callback>
+    inline void World::ForEach(Callback const& callback) {
+        static ComponentMask const required = MaskOf<ComponentTypes...>();
+        RunOnEntitiesWith(required, [&callback](EntityPtr const& entity, sysid) {
+            callback(entity, *entity->Get<ComponentTypes>()...);
+        });
+    }
+
+    template <class ...ComponentTypes, class Callback>
+    inline void World::ForEachInSystem(Callback const& callback, sysid system_id) {
+        static ComponentMask const required = MaskOf<ComponentTypes...>();
+        RunOnEntitiesInSystemWith(required, [&callback](EntityPtr const& entity, sysid) {
+            callback(entity, *entity->Get<ComponentTypes>()...);
+        }, system_id);
+    }
+
 }
@@ -24,21 +24,33 @@
 #include "targetver.h"
 
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <chrono>
+#include <condition_variable>
 #include <cmath>
 #include <cstdint>
 #include <cwchar>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #define WIN32_LEAN_AND_MEAN